@@ -0,0 +1,207 @@
+/*
+ * bench.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef BENCH_HPP_K2V7TQ0D
+#define BENCH_HPP_K2V7TQ0D
+
+#include "../support/alloc_hook.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Minimal benchmark harness shared by everything in benchmarks/.
+namespace bench {
+
+  template<typename T>
+  inline void do_not_optimize(const T& val) {
+    asm volatile("" : : "r,m"(val) : "memory");
+  }
+
+  inline void clobber() {
+    asm volatile("" : : : "memory");
+  }
+
+  /**
+   *  Returns a fixed pseudo random pattern of @p n flags where roughly
+   *  @p rate of them are set. The same seed gives the same pattern, so runs
+   *  are comparable, but the branch predictor can't learn it.
+   */
+  inline std::vector<char> fail_pattern(std::size_t n, double rate,
+                                        uint64_t seed = 0x9e3779b97f4a7c15ull) {
+    std::vector<char> pattern(n);
+    // rate * 2^64 doesn't fit a uint64_t at 1.0, and the cast would be UB.
+    const uint64_t threshold =
+      rate >= 1.0 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0);
+    uint64_t x = seed;
+    for (auto& p : pattern) {
+      // xorshift64*
+      x ^= x >> 12;
+      x ^= x << 25;
+      x ^= x >> 27;
+      p = (x * 2685821657736338717ull) < threshold || rate >= 1.0;
+    }
+    return pattern;
+  }
+
+  struct measurement {
+    double ns;     // best average per call
+    double allocs; // operator new calls per call, over every run
+  };
+
+  /**
+   *  Calls @p fn(i) for i in [0, iters) @p runs times and returns the best
+   *  average nanoseconds per call, and the heap allocations per call.
+   */
+  template<typename F>
+  measurement measure(std::size_t iters, F&& fn, int runs = 5) {
+    double best = 1e300;
+    const alloc_hook::scope allocs;
+    for (int run = 0; run < runs; ++run) {
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < iters; ++i) {
+        fn(i);
+      }
+      clobber();
+      const auto end = std::chrono::steady_clock::now();
+      const double ns =
+        std::chrono::duration<double, std::nano>(end - start).count();
+      best = std::min(best, ns / static_cast<double>(iters));
+    }
+    return {best, static_cast<double>(allocs.delta().allocations) /
+                    (static_cast<double>(iters) * runs)};
+  }
+
+  template<typename F>
+  double ns_per_op(std::size_t iters, F&& fn, int runs = 5) {
+    return measure(iters, std::forward<F>(fn), runs).ns;
+  }
+
+  // One machine readable line per measurement: bench, name, param, ns per
+  // call and allocations per call ("-" where not measured).
+  inline void report(const char* bench, const char* name, double param,
+                     double ns) {
+    std::printf("%s\t%s\t%g\t%.3f\t-\n", bench, name, param, ns);
+  }
+
+  inline void report(const char* bench, const char* name, double param,
+                     const measurement& m) {
+    std::printf("%s\t%s\t%g\t%.3f\t%.3f\n", bench, name, param, m.ns, m.allocs);
+  }
+
+  /**
+   *  Hardware counters for the calling thread, user space only, through
+   *  perf_event_open. Each counter is opened on its own so that one the CPU
+   *  (or a VM, or perf_event_paranoid) doesn't allow leaves the others
+   *  working; it reads as -1. Counts are scaled up if the kernel had to
+   *  multiplex them.
+   */
+  class perf_counters {
+  public:
+    enum counter { instructions, cycles, branch_misses, l1d_misses, count };
+
+    static const char* name(counter c) {
+      static const char* const names[count] = {"instructions", "cycles",
+                                               "branch_misses", "l1d_misses"};
+      return names[c];
+    }
+
+    perf_counters() {
+#ifdef __linux__
+      const std::uint64_t l1d_read_miss =
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      const std::uint32_t types[count]  = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                           PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+      const std::uint64_t configs[count] = {PERF_COUNT_HW_INSTRUCTIONS,
+                                            PERF_COUNT_HW_CPU_CYCLES,
+                                            PERF_COUNT_HW_BRANCH_MISSES, l1d_read_miss};
+      for (int c = 0; c < count; ++c) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = types[c];
+        attr.config         = configs[c];
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds_[c] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+      }
+#endif
+    }
+
+    ~perf_counters() {
+#ifdef __linux__
+      for (int fd : fds_) {
+        if (fd != -1) {
+          ::close(fd);
+        }
+      }
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool any() const {
+      return std::any_of(fds_, fds_ + count, [](int fd) { return fd != -1; });
+    }
+
+    void start() {
+#ifdef __linux__
+      for (int fd : fds_) {
+        if (fd != -1) {
+          ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+          ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+      }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+      for (int c = 0; c < count; ++c) {
+        values_[c] = -1;
+        if (fds_[c] == -1) {
+          continue;
+        }
+        ::ioctl(fds_[c], PERF_EVENT_IOC_DISABLE, 0);
+        std::uint64_t v[3]; // value, time enabled, time running
+        if (::read(fds_[c], v, sizeof(v)) == sizeof(v) && v[2] != 0) {
+          values_[c] = static_cast<std::int64_t>(
+            static_cast<double>(v[0]) * static_cast<double>(v[1]) / static_cast<double>(v[2]));
+        }
+      }
+#endif
+    }
+
+    // Between the last start() and stop().
+    std::int64_t operator[](counter c) const {
+      return values_[c];
+    }
+
+  private:
+    int fds_[count]             = {-1, -1, -1, -1};
+    std::int64_t values_[count] = {-1, -1, -1, -1};
+  };
+} // namespace bench
+
+#endif /* end of include guard: BENCH_HPP_K2V7TQ0D */
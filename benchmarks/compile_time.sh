@@ -0,0 +1,53 @@
+#! /bin/sh
+#
+# compile_time.sh
+# Copyright (C) 2017 rsw0x
+#
+# Distributed under terms of the MPLv2 license.
+#
+# compile_time.sh <measure binary> <output dir> [count]
+#
+# Generates a TU with <count> (default 10000) distinct Result
+# instantiations, each constructed, applied and ok_or'd, and compiles it
+# once per standard. Prints compile time, peak compiler memory and the
+# .text size of the object, one tab separated line per standard.
+
+MEASURE=$1
+OUT=$2
+COUNT=${3:-10000}
+CXX=${CXX:-c++}
+HERE=$(cd "$(dirname "$0")/.." && pwd)
+
+if [ -z "$MEASURE" ] || [ -z "$OUT" ]; then
+  echo "usage: $0 <measure binary> <output dir> [count]" >&2
+  exit 2
+fi
+
+mkdir -p "$OUT"
+SRC="$OUT/instantiations.cxx"
+
+awk -v n="$COUNT" -v inc="$HERE/result.hpp" 'BEGIN {
+  printf "#include \"%s\"\n\n", inc
+  print "template<int N> struct tag_t { int v; };"
+  print "struct err_t { const char* msg; };\n"
+  for (i = 0; i < n; i++) {
+    printf "util::Result<tag_t<%d>, err_t> make_%d(int i) {\n", i, i
+    printf "  if (i < 0) { return util::Err(err_t{\"negative\"}); }\n"
+    printf "  return tag_t<%d>{i};\n}\n", i
+    printf "int use_%d(int i) {\n", i
+    printf "  return make_%d(i).apply([](tag_t<%d>& t) { return t.v; }).ok_or(0);\n}\n", i, i
+  }
+}' > "$SRC"
+
+printf "std\tinstantiations\tseconds\tpeak_rss_kib\ttext_bytes\n"
+for std in c++14 c++17 c++20; do
+  obj="$OUT/instantiations_$std.o"
+  if ! res=$("$MEASURE" "$CXX" -std=$std -O2 -c "$SRC" -o "$obj" 2>&1 >/dev/null); then
+    echo "$std: compilation failed" >&2
+    echo "$res" | tail -5 >&2
+    continue
+  fi
+  text=$(size -A "$obj" | awk '$1 ~ /^\.text/ { sum += $2 } END { print sum + 0 }')
+  set -- $(echo "$res" | tail -1)
+  printf "%s\t%s\t%s\t%s\t%s\n" "$std" "$COUNT" "$1" "$2" "$text"
+done
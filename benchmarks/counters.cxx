@@ -0,0 +1,112 @@
+/*
+ * counters.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Hardware counters for the error paths: instructions, cycles, branch misses
+// and L1d read misses per call (bench::perf_counters) at error rates from 0
+// to 50%, to tell a regression in Try_ or apply() from a branch predictor or
+// cache effect.
+//
+//  - try:        three nested Try_ over Result<int, E>.
+//  - apply:      three apply() steps on the same Result.
+//  - error_code: three calls up returning an int code, the baseline.
+//
+// Output: the usual bench rows on stdout (bench, name, error rate, ns per
+// call, allocations per call) and, given a path (`make counters`), a CSV of
+// the counters per call there. Counters that can't be opened, in most VMs
+// and containers, are left empty.
+
+#include "../result.hpp"
+#include "bench.hpp"
+#include "workloads.hpp"
+
+#include <cstdio>
+
+namespace {
+  using namespace bench::workload;
+
+  // Measures @p fn like every other bench, then runs it once more under the
+  // counters and writes a CSV row.
+  template<typename F>
+  void sweep(std::FILE* csv, bench::perf_counters& counters, const char* name,
+             double rate, std::size_t iters, F&& fn) {
+    const bench::measurement m = bench::measure(iters, fn);
+    bench::report("counters", name, rate, m);
+    if (csv == nullptr) {
+      return;
+    }
+
+    counters.start();
+    for (std::size_t i = 0; i < iters; ++i) {
+      fn(i);
+    }
+    bench::clobber();
+    counters.stop();
+
+    std::fprintf(csv, "%s,%g,%.3f", name, rate, m.ns);
+    for (int c = 0; c < bench::perf_counters::count; ++c) {
+      const std::int64_t v = counters[static_cast<bench::perf_counters::counter>(c)];
+      if (v < 0) {
+        std::fputs(",", csv);
+      } else {
+        std::fprintf(csv, ",%.4f", static_cast<double>(v) / static_cast<double>(iters));
+      }
+    }
+    std::fputs("\n", csv);
+  }
+} // namespace
+
+int main(int argc, char** argv) {
+  std::FILE* csv = nullptr;
+  if (argc > 1 && (csv = std::fopen(argv[1], "w")) == nullptr) {
+    std::perror(argv[1]);
+    return 1;
+  }
+
+  bench::perf_counters counters;
+  if (csv != nullptr) {
+    if (!counters.any()) {
+      std::fprintf(stderr, "counters: no hardware counters available, the CSV only has ns.\n");
+    }
+    std::fputs("workload,error_rate,ns", csv);
+    for (int c = 0; c < bench::perf_counters::count; ++c) {
+      std::fprintf(csv, ",%s", bench::perf_counters::name(static_cast<bench::perf_counters::counter>(c)));
+    }
+    std::fputs("\n", csv);
+  }
+
+  constexpr std::size_t iters = 1 << 20;
+  const double rates[] = {0.0, 0.001, 0.01, 0.1, 0.5};
+  for (double rate : rates) {
+    const auto pattern = bench::fail_pattern(iters, rate);
+    int sink = 0;
+
+    sweep(csv, counters, "try", rate, iters, [&](std::size_t i) {
+      auto r = try3(static_cast<int>(i), pattern[i]);
+      sink += r.is_ok() ? r.ok() : -r.err().code;
+    });
+
+    sweep(csv, counters, "apply", rate, iters, [&](std::size_t i) {
+      auto r = make(static_cast<int>(i), pattern[i])
+                 .apply([](int x) { return x + 1; })
+                 .apply([](int x) { return x * 3; })
+                 .apply([](int x) { return x - 2; });
+      sink += r.is_ok() ? r.ok() : -r.err().code;
+    });
+
+    sweep(csv, counters, "error_code", rate, iters, [&](std::size_t i) {
+      int x;
+      const int ec = code3(static_cast<int>(i), pattern[i], &x);
+      sink += ec == 0 ? x : -ec;
+    });
+
+    bench::do_not_optimize(sink);
+  }
+
+  if (csv != nullptr) {
+    std::fclose(csv);
+  }
+}
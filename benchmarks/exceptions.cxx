@@ -0,0 +1,100 @@
+/*
+ * exceptions.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Cost of the exception <-> Result boundary at different throw rates.
+//
+// Every row is the same small computation failing at the given rate:
+//  - exception:       throws, caught right at the call site.
+//  - catch_as_result: throws, mapped into a Result by catch_as_result.
+//  - result:          returns a Result directly.
+//  - into_exception:  returns a Result, converted back into an exception.
+//
+// Output: bench, name, throw rate, ns per call, operator new calls per call
+// (exception objects come from __cxa_allocate_exception and aren't counted).
+
+#include "../exceptions.hpp"
+#include "bench.hpp"
+
+#include <exception>
+
+namespace {
+  struct bench_error : std::exception {
+    int code;
+
+    explicit bench_error(int c)
+      : code(c) {
+    }
+
+    const char* what() const noexcept override {
+      return "bench_error";
+    }
+  };
+
+  struct bench_err {
+    int code;
+  };
+
+  __attribute__((noinline)) int compute_or_throw(int v, bool fail) {
+    if (fail) {
+      throw bench_error{v};
+    }
+    return v * 3 + 1;
+  }
+
+  __attribute__((noinline)) util::Result<int, bench_err> compute(int v,
+                                                                 bool fail) {
+    if (fail) {
+      return util::Err(bench_err{v});
+    }
+    return v * 3 + 1;
+  }
+} // namespace
+
+int main() {
+  constexpr std::size_t iters = 1 << 20;
+  const double rates[] = {0.0, 0.001, 0.01, 0.1, 0.5, 1.0};
+
+  for (double rate : rates) {
+    const auto pattern = bench::fail_pattern(iters, rate);
+    int sink = 0;
+
+    bench::report("exceptions", "exception", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    try {
+                      sink += compute_or_throw(static_cast<int>(i), pattern[i]);
+                    } catch (const bench_error& e) {
+                      sink -= e.code;
+                    }
+                  }));
+
+    bench::report(
+      "exceptions", "catch_as_result", rate,
+      bench::measure(iters, [&](std::size_t i) {
+        auto r = util::catch_as_result<bench_error>(
+          [&] { return compute_or_throw(static_cast<int>(i), pattern[i]); });
+        sink += r.is_ok() ? r.ok() : -1;
+      }));
+
+    bench::report("exceptions", "result", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    auto r = compute(static_cast<int>(i), pattern[i]);
+                    sink += r.is_ok() ? r.ok() : -r.err().code;
+                  }));
+
+    bench::report(
+      "exceptions", "into_exception", rate,
+      bench::measure(iters, [&](std::size_t i) {
+        try {
+          sink += util::into_exception(compute(static_cast<int>(i), pattern[i]));
+        } catch (const util::result_error<bench_err>& e) {
+          sink -= e.error.code;
+        }
+      }));
+
+    bench::do_not_optimize(sink);
+  }
+}
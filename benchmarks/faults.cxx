@@ -0,0 +1,107 @@
+/*
+ * faults.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Degraded mode: the same work with injected faults (fault.hpp) at
+// increasing rates. Needs RESULT_FAULTS=1 (`make FAULTS=1 benchmarks`);
+// without it there's nothing to inject and it only says so.
+//
+//  - try_chain:     four nested Try_ over Result<int, io_error>, failing at
+//                   the rate at every Try_.
+//  - read_file:     util::open + util::as_string of a small file, failing
+//                   at the rate in open, file_size and as_string each.
+//  - read_file_p99: the 99th percentile of single read_file calls.
+//
+// The seed is fixed, so every run fails the same calls.
+//
+// Output: bench, name, fault rate, ns per call, allocations per call.
+
+#include "../utils.hpp"
+#include "bench.hpp"
+
+#if RESULT_FAULTS
+#include "../fault.hpp"
+#include "../support/temp_file.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+  using util::fault::point;
+
+  __attribute__((noinline)) util::IOError<int> leaf(int v) {
+    return util::Ok(v);
+  }
+
+  __attribute__((noinline)) util::IOError<int> chain(int v, int depth) {
+    const int x = Try_(depth == 0 ? leaf(v) : chain(v + 1, depth - 1));
+    return util::Ok(x * 3);
+  }
+
+  __attribute__((noinline)) util::IOError<std::string> read_file(const char* path) {
+    const util::fstream_ptr f = Try_(util::open(path, util::openmode::in));
+    return util::as_string(f);
+  }
+
+  void set_rate(std::initializer_list<point> points, double rate) {
+    util::fault::reset();
+    for (point p : points) {
+      util::fault::set(p, rate);
+    }
+    util::fault::set_seed(0x5eed);
+  }
+} // namespace
+
+int main() {
+  const support::temp_file file("key=value\n");
+  if (!file) {
+    std::perror("faults: temporary file");
+    return 1;
+  }
+  const char* path = file.path();
+
+  const double rates[] = {0.0, 0.001, 0.01, 0.1, 0.5};
+  for (double rate : rates) {
+    int sink = 0;
+
+    set_rate({point::try_}, rate);
+    bench::report("faults", "try_chain", rate,
+                  bench::measure(1 << 20, [&](std::size_t i) {
+                    auto r = chain(static_cast<int>(i), 3);
+                    sink += r.is_ok() ? r.ok() : r.err().errnum();
+                  }));
+
+    set_rate({point::open, point::file_size, point::as_string}, rate);
+    bench::report("faults", "read_file", rate,
+                  bench::measure(1 << 14, [&](std::size_t) {
+                    sink += read_file(path).is_ok();
+                  }));
+
+    set_rate({point::open, point::file_size, point::as_string}, rate);
+    std::vector<double> latencies(1 << 14);
+    for (double& ns : latencies) {
+      const auto start = std::chrono::steady_clock::now();
+      sink += read_file(path).is_ok();
+      const auto end = std::chrono::steady_clock::now();
+      ns = std::chrono::duration<double, std::nano>(end - start).count();
+    }
+    const auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+    std::nth_element(latencies.begin(), p99, latencies.end());
+    bench::report("faults", "read_file_p99", rate, *p99);
+
+    bench::do_not_optimize(sink);
+  }
+  util::fault::reset();
+}
+#else
+#include <cstdio>
+
+int main() {
+  std::fprintf(stderr, "faults: built without RESULT_FAULTS=1, nothing to inject.\n");
+}
+#endif
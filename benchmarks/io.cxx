@@ -0,0 +1,309 @@
+/*
+ * io.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Reading a whole file, 4 KiB to several GiB, with a warm page cache and a
+// cold one (posix_fadvise(POSIX_FADV_DONTNEED) before every read):
+//
+//  - as_string: util::open + util::as_string.
+//  - read:      open(2), fstat, one malloc and read(2) until the end.
+//  - mmap:      mmap and a load from every page, so every page is faulted in.
+//  - map_file:  util::map_file with populate, and the same loads.
+//  - direct:    O_DIRECT read(2)s of 1 MiB into an aligned buffer. It skips
+//               the page cache, so it only has the one row.
+//
+// bench_io [--dir <dir>] [--max <bytes>] [--csv <path>]
+//
+// Files go in --dir (default $TMPDIR or /tmp) and are removed afterwards;
+// on tmpfs there's no cold cache and no O_DIRECT. --max (default 64M, K, M
+// and G suffixes) is the largest file. `make io-bench` goes up to 4G.
+//
+// Output: the usual bench rows on stdout (bench, name, file size, ns per
+// read, allocations per read) and with --csv the GB/s and read syscalls per
+// MiB (from /proc/self/io) of each.
+
+#include "../utils.hpp"
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  constexpr std::size_t direct_chunk = 1 << 20;
+
+  // read(2)-like syscalls this process has made so far.
+  std::uint64_t read_syscalls() {
+    std::FILE* f = std::fopen("/proc/self/io", "r");
+    if (f == nullptr) {
+      return 0;
+    }
+    char key[32];
+    unsigned long long value;
+    std::uint64_t syscr = 0;
+    while (std::fscanf(f, "%31s %llu", key, &value) == 2) {
+      if (std::strcmp(key, "syscr:") == 0) {
+        syscr = value;
+      }
+    }
+    std::fclose(f);
+    return syscr;
+  }
+
+  bool drop_cache(const char* path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+      return false;
+    }
+    const bool dropped = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return dropped;
+  }
+
+  bool make_file(const std::string& path, std::size_t size) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) {
+      return false;
+    }
+    std::vector<char> chunk(std::min<std::size_t>(size, 1 << 20));
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+      chunk[i] = static_cast<char>('a' + i % 26);
+    }
+    bool ok = true;
+    for (std::size_t done = 0; ok && done < size;) {
+      const ssize_t n = ::write(fd, chunk.data(), std::min(chunk.size(), size - done));
+      ok = n > 0;
+      done += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    ok = ok && ::fsync(fd) == 0; // clean pages, or DONTNEED can't drop them
+    ::close(fd);
+    return ok;
+  }
+
+  std::size_t with_as_string(const char* path) {
+    auto f = util::open(path, util::openmode::in);
+    if (f.is_err()) {
+      return 0;
+    }
+    auto s = util::as_string(f.ok());
+    return s.is_ok() ? s.ok().size() : 0;
+  }
+
+  std::size_t with_read(const char* path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+      return 0;
+    }
+    struct stat st;
+    std::size_t done = 0;
+    if (::fstat(fd, &st) == 0) {
+      const std::size_t size = static_cast<std::size_t>(st.st_size);
+      char* buf = static_cast<char*>(std::malloc(size));
+      while (buf != nullptr && done < size) {
+        const ssize_t n = ::read(fd, buf + done, size - done);
+        if (n <= 0) {
+          break;
+        }
+        done += static_cast<std::size_t>(n);
+      }
+      bench::do_not_optimize(buf);
+      std::free(buf);
+    }
+    ::close(fd);
+    return done;
+  }
+
+  std::size_t with_mmap(const char* path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+      return 0;
+    }
+    struct stat st;
+    std::size_t done = 0;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      const std::size_t size = static_cast<std::size_t>(st.st_size);
+      void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        const volatile char* bytes = static_cast<const char*>(p);
+        char sum = 0;
+        for (std::size_t i = 0; i < size; i += 4096) {
+          sum = static_cast<char>(sum + bytes[i]);
+        }
+        bench::do_not_optimize(sum);
+        ::munmap(p, size);
+        done = size;
+      }
+    }
+    ::close(fd);
+    return done;
+  }
+
+  std::size_t with_map_file(const char* path) {
+    util::map_options options;
+    options.populate = true;
+    auto view = util::map_file(path, options);
+    if (view.is_err()) {
+      return 0;
+    }
+    const volatile char* bytes = view.ok().data();
+    char sum = 0;
+    for (std::size_t i = 0; i < view.ok().size(); i += 4096) {
+      sum = static_cast<char>(sum + bytes[i]);
+    }
+    bench::do_not_optimize(sum);
+    return view.ok().size();
+  }
+
+  std::size_t with_direct(const char* path) {
+    const int fd = ::open(path, O_RDONLY | O_DIRECT);
+    if (fd == -1) {
+      return 0;
+    }
+    void* buf = nullptr;
+    std::size_t done = 0;
+    if (::posix_memalign(&buf, 4096, direct_chunk) == 0) {
+      ssize_t n;
+      while ((n = ::read(fd, buf, direct_chunk)) > 0) {
+        done += static_cast<std::size_t>(n);
+      }
+      std::free(buf);
+    }
+    ::close(fd);
+    return done;
+  }
+
+  struct result {
+    double ns;
+    double reads_per_mib;
+    double allocs;
+  };
+
+  // Best of @p runs reads.
+  template<typename F>
+  result run(const char* path, std::size_t size, std::size_t runs, bool cold, F&& fn,
+             bool& failed) {
+    double best = 1e300;
+    const std::uint64_t reads_before = read_syscalls();
+    const alloc_hook::scope allocs;
+    for (std::size_t i = 0; i < runs; ++i) {
+      if (cold && !drop_cache(path)) {
+        failed = true;
+      }
+      const auto start    = std::chrono::steady_clock::now();
+      const std::size_t n = fn(path);
+      const auto end      = std::chrono::steady_clock::now();
+      failed              = failed || n != size;
+      best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    // Leaves out the reads of /proc/self/io itself.
+    const double reads = std::max(0.0, static_cast<double>(read_syscalls() - reads_before) - 2);
+    const double mib   = static_cast<double>(size) * static_cast<double>(runs) / (1 << 20);
+    return {best, reads / mib,
+            static_cast<double>(allocs.delta().allocations) / static_cast<double>(runs)};
+  }
+
+  std::size_t parse_size(const char* s) {
+    char* end;
+    std::size_t n = std::strtoull(s, &end, 10);
+    switch (*end) {
+      case 'G': n <<= 10; // fallthrough
+      case 'M': n <<= 10; // fallthrough
+      case 'K': n <<= 10;
+    }
+    return n;
+  }
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* tmpdir = std::getenv("TMPDIR");
+  std::string dir    = tmpdir != nullptr ? tmpdir : "/tmp";
+  std::size_t max    = std::size_t(64) << 20;
+  std::FILE* csv     = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--dir") == 0) {
+      dir = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--max") == 0) {
+      max = parse_size(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--csv") == 0 &&
+               (csv = std::fopen(argv[i + 1], "w")) == nullptr) {
+      std::perror(argv[i + 1]);
+      return 1;
+    }
+  }
+  if (csv != nullptr) {
+    std::fputs("method,cache,bytes,ns,gb_per_s,reads_per_mib\n", csv);
+  }
+
+  struct method {
+    const char* name;
+    std::size_t (*fn)(const char*);
+    bool uses_cache;
+  };
+  const method methods[] = {{"as_string", &with_as_string, true},
+                            {"read", &with_read, true},
+                            {"mmap", &with_mmap, true},
+                            {"map_file", &with_map_file, true},
+                            {"direct", &with_direct, false}};
+
+  // 4 KiB, 64 KiB, 1 MiB... up to max, and max.
+  std::vector<std::size_t> sizes;
+  for (std::size_t size = 4096; size < max; size *= 16) {
+    sizes.push_back(size);
+  }
+  sizes.push_back(max);
+
+  bool warned_cold = false, warned_direct = false;
+  for (std::size_t size : sizes) {
+    const std::string path = dir + "/result_io_bench_" + std::to_string(size);
+    if (!make_file(path, size)) {
+      std::fprintf(stderr, "io: can't write %s: %s\n", path.c_str(), std::strerror(errno));
+      return 1;
+    }
+    for (const method& m : methods) {
+      for (bool cold : {false, true}) {
+        if (cold && !m.uses_cache) {
+          continue;
+        }
+        // Enough to read 256 MiB from the cache, 5 from the disk.
+        const std::size_t runs =
+          m.uses_cache && !cold ? std::max<std::size_t>(5, (256u << 20) / size) : 5;
+        bool failed    = false;
+        const result r = run(path.c_str(), size, runs, cold, m.fn, failed);
+        if (failed) {
+          // tmpfs and friends: no O_DIRECT, nothing to drop.
+          bool& warned = m.uses_cache ? warned_cold : warned_direct;
+          if (!warned) {
+            std::fprintf(stderr, "io: %s%s isn't supported in %s, skipped.\n", m.name,
+                         m.uses_cache ? " with a cold cache" : "", dir.c_str());
+            warned = true;
+          }
+          continue;
+        }
+        const std::string name = std::string(m.name) + (!m.uses_cache ? "" : cold ? "_cold" : "_warm");
+        bench::report("io", name.c_str(), static_cast<double>(size), bench::measurement{r.ns, r.allocs});
+        if (csv != nullptr) {
+          std::fprintf(csv, "%s,%s,%zu,%.0f,%.3f,%.3f\n", m.name,
+                       !m.uses_cache ? "none" : cold ? "cold" : "warm", size, r.ns,
+                       static_cast<double>(size) / r.ns, r.reads_per_mib);
+        }
+      }
+    }
+    std::remove(path.c_str());
+  }
+  if (csv != nullptr) {
+    std::fclose(csv);
+  }
+}
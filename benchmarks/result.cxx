@@ -0,0 +1,148 @@
+/*
+ * result.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Cost of the basic Result operations, and of propagating an error three
+// calls up compared with the alternatives, at different failure rates.
+//
+//  - construct:  a noinline function returning Result<int, E>.
+//  - access:     the same, then ok() or err().
+//  - apply:      the same, then three apply() steps.
+//  - ok_or:      the same, then ok_or().
+//  - try:        three nested Try_ over it.
+//  - exception:  three calls up from a throw, caught at the top.
+//  - error_code: three calls up returning an int code, value out parameter.
+//  - optional:   three calls up returning std::optional<int> (C++17).
+//
+// Output: bench, name, failure rate, ns per call, allocations per call.
+
+#include "../result.hpp"
+#include "bench.hpp"
+#include "workloads.hpp"
+
+#if __cplusplus >= 201703L
+#include <optional>
+#endif
+
+namespace {
+  using namespace bench::workload;
+
+  struct bench_error {
+    int code;
+  };
+
+#if RESULT_EXCEPTIONS
+  __attribute__((noinline)) int throw1(int v, bool fail) {
+    if (fail) {
+      throw bench_error{v};
+    }
+    return v + 1;
+  }
+
+  __attribute__((noinline)) int throw2(int v, bool fail) {
+    return throw1(v, fail) * 3;
+  }
+
+  __attribute__((noinline)) int throw3(int v, bool fail) {
+    return throw2(v, fail) - 2;
+  }
+#endif
+
+#if __cplusplus >= 201703L
+  __attribute__((noinline)) std::optional<int> opt1(int v, bool fail) {
+    if (fail) {
+      return std::nullopt;
+    }
+    return v + 1;
+  }
+
+  __attribute__((noinline)) std::optional<int> opt2(int v, bool fail) {
+    const std::optional<int> x = opt1(v, fail);
+    if (!x) {
+      return std::nullopt;
+    }
+    return *x * 3;
+  }
+
+  __attribute__((noinline)) std::optional<int> opt3(int v, bool fail) {
+    const std::optional<int> x = opt2(v, fail);
+    if (!x) {
+      return std::nullopt;
+    }
+    return *x - 2;
+  }
+#endif
+} // namespace
+
+int main() {
+  constexpr std::size_t iters = 1 << 20;
+  const double rates[] = {0.0, 0.01, 0.1, 0.5};
+
+  for (double rate : rates) {
+    const auto pattern = bench::fail_pattern(iters, rate);
+    int sink = 0;
+
+    bench::report("result", "construct", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    auto r = make(static_cast<int>(i), pattern[i]);
+                    bench::do_not_optimize(r);
+                  }));
+
+    bench::report("result", "access", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    auto r = make(static_cast<int>(i), pattern[i]);
+                    sink += r.is_ok() ? r.ok() : -r.err().code;
+                  }));
+
+    bench::report("result", "apply", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    auto r = make(static_cast<int>(i), pattern[i])
+                               .apply([](int x) { return x + 1; })
+                               .apply([](int x) { return x * 3; })
+                               .apply([](int x) { return x - 2; });
+                    sink += r.is_ok() ? r.ok() : -r.err().code;
+                  }));
+
+    bench::report("result", "ok_or", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    sink += make(static_cast<int>(i), pattern[i]).ok_or(-1);
+                  }));
+
+    bench::report("result", "try", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    auto r = try3(static_cast<int>(i), pattern[i]);
+                    sink += r.is_ok() ? r.ok() : -r.err().code;
+                  }));
+
+#if RESULT_EXCEPTIONS
+    bench::report("result", "exception", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    try {
+                      sink += throw3(static_cast<int>(i), pattern[i]);
+                    } catch (const bench_error& e) {
+                      sink -= e.code;
+                    }
+                  }));
+#endif
+
+    bench::report("result", "error_code", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    int x;
+                    const int ec = code3(static_cast<int>(i), pattern[i], &x);
+                    sink += ec == 0 ? x : -ec;
+                  }));
+
+#if __cplusplus >= 201703L
+    bench::report("result", "optional", rate,
+                  bench::measure(iters, [&](std::size_t i) {
+                    const std::optional<int> x = opt3(static_cast<int>(i), pattern[i]);
+                    sink += x ? *x : -1;
+                  }));
+#endif
+
+    bench::do_not_optimize(sink);
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ * timing.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Per call overhead of util::timed().
+//
+//  - now:      one timing::now() read.
+//  - direct:   a small Result returning call.
+//  - timed:    the same call through timed().
+//  - overhead: timed - direct.
+//
+// Output: bench, name, error rate, ns per call, allocations per call.
+
+#include "../timing.hpp"
+#include "bench.hpp"
+
+namespace {
+  struct bench_err {
+    int code;
+  };
+
+  __attribute__((noinline)) util::Result<int, bench_err> compute(int v,
+                                                                 bool fail) {
+    if (fail) {
+      return util::Err(bench_err{v});
+    }
+    return v * 3 + 1;
+  }
+} // namespace
+
+int main() {
+  constexpr std::size_t iters = 1 << 22;
+  const double rates[] = {0.0, 0.1, 0.5};
+  static util::timing::site compute_site{"compute"};
+
+  std::uint64_t ticks = 0;
+  bench::report("timing", "now", 0,
+                bench::ns_per_op(iters, [&](std::size_t) {
+                  ticks += util::timing::now();
+                }));
+  bench::do_not_optimize(ticks);
+
+  for (double rate : rates) {
+    const auto pattern = bench::fail_pattern(iters, rate);
+    int sink = 0;
+
+    const bench::measurement direct = bench::measure(iters, [&](std::size_t i) {
+      auto r = compute(static_cast<int>(i), pattern[i]);
+      sink += r.is_ok() ? r.ok() : -r.err().code;
+    });
+
+    const bench::measurement timed = bench::measure(iters, [&](std::size_t i) {
+      auto r = util::timed(compute_site, [&] {
+        return compute(static_cast<int>(i), pattern[i]);
+      });
+      sink += r.is_ok() ? r.ok() : -r.err().code;
+    });
+
+    bench::report("timing", "direct", rate, direct);
+    bench::report("timing", "timed", rate, timed);
+    bench::report("timing", "overhead", rate, timed.ns - direct.ns);
+    bench::do_not_optimize(sink);
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ * unwind.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Cost of capturing a stack trace at different stack depths.
+//
+//  - unwind:        backward's _Unwind_Backtrace walk (BACKWARD_HAS_UNWIND).
+//  - frame_pointer: backward's frame pointer walk (BACKWARD_HAS_FP).
+//  - stacktrace:    backward::StackTrace::load_here() with the unwinder the
+//                   build selected, including its vector.
+//
+// Built with -fno-omit-frame-pointer (see the makefile); both walks must
+// find the same frames or a mismatch is reported on stderr.
+//
+// Output: bench, name, stack depth, ns per capture, allocations per capture.
+
+#include "../contrib/backward.hpp"
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+  constexpr std::size_t max_frames = 256;
+
+  struct collect {
+    void** frames;
+
+    void operator()(std::size_t idx, void* addr) {
+      frames[idx] = addr;
+    }
+  };
+
+  __attribute__((noinline)) std::size_t walk_frame_pointers(void** frames) {
+    return backward::details::unwind_frame_pointers(
+      collect{frames}, __builtin_frame_address(0), max_frames);
+  }
+
+  __attribute__((noinline)) std::size_t walk_unwind(void** frames) {
+#if BACKWARD_HAS_UNWIND == 1
+    return backward::details::unwind(collect{frames}, max_frames);
+#else
+    // Built with BACKWARD_HAS_FP: there's no unwinder to compare against.
+    return walk_frame_pointers(frames);
+#endif
+  }
+
+  void measure_here(unsigned depth) {
+    constexpr std::size_t iters = 1 << 14;
+    void* by_unwind[max_frames];
+    void* by_fp[max_frames];
+
+    const std::size_t n_unwind = walk_unwind(by_unwind);
+    const std::size_t n_fp     = walk_frame_pointers(by_fp);
+    // The frame pointer walk stops in libc's startup code, which has none.
+    const std::size_t common = std::min(n_unwind, n_fp);
+    if (n_fp < depth ||
+        !std::equal(by_unwind + 1, by_unwind + common, by_fp + 1)) {
+      std::fprintf(stderr, "unwind: frames differ at depth %u (%zu vs %zu)\n",
+                   depth, n_unwind, n_fp);
+    }
+
+    std::size_t sink = 0;
+    bench::report("unwind", "unwind", depth,
+                  bench::measure(iters, [&](std::size_t) {
+                    sink += walk_unwind(by_unwind);
+                  }));
+    bench::report("unwind", "frame_pointer", depth,
+                  bench::measure(iters, [&](std::size_t) {
+                    sink += walk_frame_pointers(by_fp);
+                  }));
+    bench::report("unwind", "stacktrace", depth,
+                  bench::measure(iters, [&](std::size_t) {
+                    backward::StackTrace st;
+                    sink += st.load_here(max_frames);
+                  }));
+    bench::do_not_optimize(sink);
+  }
+
+  __attribute__((noinline)) void recurse(unsigned depth, unsigned target) {
+    if (depth < target) {
+      recurse(depth + 1, target);
+    } else {
+      measure_here(target);
+    }
+    bench::clobber(); // no tail call
+  }
+} // namespace
+
+int main() {
+  for (unsigned depth : {8u, 32u, 128u}) {
+    recurse(0, depth);
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * workloads.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef WORKLOADS_HPP_R8N3WJ5C
+#define WORKLOADS_HPP_R8N3WJ5C
+
+#include "../result.hpp"
+
+// Error paths measured by more than one benchmark, kept here so that every
+// bench times the same code. All noinline: each call is a real call.
+namespace bench {
+  namespace workload {
+    struct bench_err {
+      int code;
+    };
+
+    __attribute__((noinline)) inline util::Result<int, bench_err> make(int v, bool fail) {
+      if (fail) {
+        return util::Err(bench_err{v});
+      }
+      return v;
+    }
+
+    // Three nested Try_ over make().
+    __attribute__((noinline)) inline util::Result<int, bench_err> try1(int v, bool fail) {
+      const int x = Try_(make(v, fail));
+      return x + 1;
+    }
+
+    __attribute__((noinline)) inline util::Result<int, bench_err> try2(int v, bool fail) {
+      const int x = Try_(try1(v, fail));
+      return x * 3;
+    }
+
+    __attribute__((noinline)) inline util::Result<int, bench_err> try3(int v, bool fail) {
+      const int x = Try_(try2(v, fail));
+      return x - 2;
+    }
+
+    // The same three calls returning an int code, the value through @p out.
+    __attribute__((noinline)) inline int code1(int v, bool fail, int* out) {
+      if (fail) {
+        return v | 1;
+      }
+      *out = v + 1;
+      return 0;
+    }
+
+    __attribute__((noinline)) inline int code2(int v, bool fail, int* out) {
+      int x;
+      if (const int ec = code1(v, fail, &x)) {
+        return ec;
+      }
+      *out = x * 3;
+      return 0;
+    }
+
+    __attribute__((noinline)) inline int code3(int v, bool fail, int* out) {
+      int x;
+      if (const int ec = code2(v, fail, &x)) {
+        return ec;
+      }
+      *out = x - 2;
+      return 0;
+    }
+  } // namespace workload
+} // namespace bench
+
+#endif /* !WORKLOADS_HPP_R8N3WJ5C */
@@ -0,0 +1,121 @@
+#! /bin/sh
+#
+# check.sh
+# Copyright (C) 2017 rsw0x
+#
+# Distributed under terms of the MPLv2 license.
+#
+# check.sh <output dir> [compiler...]
+#
+# Compiles corpus.cxx at -O2 with each compiler (default: $CXX, or c++),
+# disassembles it with objdump and checks the "// codegen:" lines in it:
+# instruction counts against the hand-written twins, and what each function
+# calls. Padding nops aren't counted, and the .cold part GCC splits off a
+# function counts as the function's own code, calls included. Compilers
+# that aren't installed are skipped. Exits 1 if any check failed.
+
+OUT=$1
+HERE=$(cd "$(dirname "$0")" && pwd)
+
+if [ -z "$OUT" ]; then
+  echo "usage: $0 <output dir> [compiler...]" >&2
+  exit 2
+fi
+shift
+[ $# -eq 0 ] && set -- "${CXX:-c++}"
+
+mkdir -p "$OUT"
+CHECKS="$OUT/checks.txt"
+sed -n 's,^ *// codegen: *,,p' "$HERE/corpus.cxx" > "$CHECKS"
+
+# <function> <instructions> <symbols it calls or jumps to>..., per function,
+# with foo.cold folded into foo and jumps within foo left out.
+summarize() {
+  objdump -d -r --no-show-raw-insn "$1" | awk '
+    function call(sym) {
+      sub(/[-+]0x[0-9a-f]+$/, "", sym)
+      sub(/\.cold$/, "", sym)
+      if (sym != fn) calls[fn] = calls[fn] " " sym
+    }
+    /^[0-9a-f]+ <.*>:$/ { fn = $2; gsub(/[<>:]/, "", fn); sub(/\.cold$/, "", fn); jump = 0; next }
+    fn == "" { next }
+    /^[ \t]+[0-9a-f]+: R_/ {
+      if (jump) call($3)
+      next
+    }
+    /^ *[0-9a-f]+:\t/ {
+      insn = $0
+      sub(/^ *[0-9a-f]+:\t/, "", insn)
+      jump = 0
+      if (insn ~ /^(nop|data16|cs nop|xchg +%ax,%ax|int3)/) next
+      count[fn]++
+      if (insn ~ /^(call|jmp|b |bl )/) {
+        jump = 1
+        if (match(insn, /<[^>+]+/)) call(substr(insn, RSTART + 1, RLENGTH - 1))
+      }
+    }
+    END { for (f in count) print f, count[f] calls[f] }'
+}
+
+status=0
+for cxx in "$@"; do
+  if ! command -v "$cxx" > /dev/null 2>&1; then
+    echo "$cxx: not installed, skipped"
+    continue
+  fi
+  obj="$OUT/corpus_$(basename "$cxx").o"
+  if ! "$cxx" -std=c++14 -O2 -DNDEBUG -I"$HERE/.." -c "$HERE/corpus.cxx" -o "$obj"; then
+    echo "$cxx: corpus.cxx doesn't compile"
+    status=1
+    continue
+  fi
+  summary="$obj.txt"
+  summarize "$obj" > "$summary"
+
+  awk -v cxx="$cxx" '
+    FNR == NR { insns[$1] = $2; line[$1] = $0; next }
+    function need(f) {
+      if (!(f in insns)) { printf "%s: FAIL %s not found\n", cxx, f; failed = 1; return 0 }
+      return 1
+    }
+    $2 == "<=" {
+      if (!need($1) || !need($3)) next
+      slack = ($4 == "+") ? $5 : 0
+      ok = insns[$1] <= insns[$3] + slack
+      printf "%s: %s %s: %d instructions, %s has %d (+%d allowed)\n", cxx, ok ? "ok  " : "FAIL",
+             $1, insns[$1], $3, insns[$3], slack
+      if (!ok) failed = 1
+      next
+    }
+    $2 == "no-call" {
+      if (!need($1)) next
+      n = split(line[$1], called, " ")
+      for (i = 3; i <= NF; ++i) {
+        hit = ""
+        for (j = 3; j <= n; ++j) if (index(called[j], $i)) hit = called[j]
+        if (hit == "") printf "%s: ok   %s doesn'"'"'t call %s\n", cxx, $1, $i
+        else printf "%s: FAIL %s calls %s\n", cxx, $1, hit
+        if (hit != "") failed = 1
+      }
+      next
+    }
+    $2 == "only-calls" {
+      if (!need($1)) next
+      n = split(line[$1], called, " ")
+      bad = ""
+      for (j = 3; j <= n; ++j) {
+        allowed = 0
+        for (i = 3; i <= NF; ++i) if (index(called[j], $i)) allowed = 1
+        if (!allowed && index(bad " ", " " called[j] " ") == 0) bad = bad " " called[j]
+      }
+      allow = ""
+      for (i = 3; i <= NF; ++i) allow = allow " " $i
+      if (bad == "") printf "%s: ok   %s only calls%s\n", cxx, $1, allow == "" ? " nothing" : allow
+      else printf "%s: FAIL %s calls%s\n", cxx, $1, bad
+      if (bad != "") failed = 1
+      next
+    }
+    { printf "%s: FAIL bad check: %s\n", cxx, $0; failed = 1 }
+    END { exit failed }' "$summary" "$CHECKS" || status=1
+done
+exit $status
@@ -0,0 +1,131 @@
+/*
+ * corpus.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Pairs of functions doing the same thing through Result and through
+// hand-written error codes, checked by check.sh after compiling this at -O2.
+// The "// codegen:" lines are the checks:
+//
+//   // codegen: <fn> <= <other> [+ <n>]
+//     <fn> has at most <n> (default 0) more instructions than <other>.
+//   // codegen: <fn> no-call <symbol>...
+//     <fn> doesn't call or jump to anything whose name contains <symbol>.
+//   // codegen: <fn> only-calls <symbol>...
+//     Everything <fn> calls or jumps to has one of the <symbol>s in its
+//     name. With none, <fn> calls nothing.
+//
+// Names are the mangled ones, and a .cold part is checked as part of its
+// function: Result may abort through its out of line abort_(), but never
+// call fprintf or abort itself.
+//
+// Functions are extern "C" so that their symbols are their names. The leaves
+// are only declared: calls to them stay calls.
+//
+// The slack is what GCC 12 needs today, plus a little: Result is returned
+// through memory, and every access checks the validity byte, whose invalid
+// state calls the out of line abort_(). Lower it when the codegen gets
+// better; raising it is a decision, not a fix.
+
+#include "../result.hpp"
+
+namespace {
+  struct err_t {
+    int code;
+  };
+} // namespace
+
+using result_t = util::Result<int, err_t>;
+
+extern "C" {
+  // Leaves, defined elsewhere.
+  result_t leaf(int v);
+  int leaf_code(int v, int* out);
+
+  // codegen: result_make <= code_make + 4
+  // codegen: result_make no-call abort fprintf
+  result_t result_make(int v) {
+    if (v < 0) {
+      return util::Err(err_t{v});
+    }
+    return v * 2;
+  }
+
+  int code_make(int v, int* out) {
+    if (v < 0) {
+      return v;
+    }
+    *out = v * 2;
+    return 0;
+  }
+
+  // Accessors behind the check inline, with the message and abort left
+  // out of line.
+  // codegen: result_access <= code_access + 8
+  // codegen: result_access only-calls leaf abort_
+  int result_access(int v) {
+    const result_t r = leaf(v);
+    return r.is_ok() ? r.ok() : -r.err().code;
+  }
+
+  int code_access(int v) {
+    int x;
+    const int ec = leaf_code(v, &x);
+    return ec == 0 ? x : -ec;
+  }
+
+  // codegen: result_try <= code_try + 34
+  // codegen: result_try only-calls leaf abort_
+  result_t result_try(int v) {
+    const int a = Try_(leaf(v));
+    const int b = Try_(leaf(a));
+    const int c = Try_(leaf(b));
+    return a + b + c;
+  }
+
+  int code_try(int v, int* out) {
+    int a, b, c;
+    if (const int ec = leaf_code(v, &a)) {
+      return ec;
+    }
+    if (const int ec = leaf_code(a, &b)) {
+      return ec;
+    }
+    if (const int ec = leaf_code(b, &c)) {
+      return ec;
+    }
+    *out = a + b + c;
+    return 0;
+  }
+
+  // codegen: result_apply <= code_apply + 16
+  // codegen: result_apply only-calls leaf abort_
+  result_t result_apply(int v) {
+    return leaf(v)
+      .apply([](int x) { return x + 1; })
+      .apply([](int x) { return x * 3; })
+      .apply([](int x) { return x - 2; });
+  }
+
+  int code_apply(int v, int* out) {
+    int x;
+    if (const int ec = leaf_code(v, &x)) {
+      return ec;
+    }
+    *out = (x + 1) * 3 - 2;
+    return 0;
+  }
+
+  // codegen: result_ok_or <= code_ok_or + 2
+  // codegen: result_ok_or no-call abort fprintf
+  int result_ok_or(int v) {
+    return leaf(v).ok_or(-1);
+  }
+
+  int code_ok_or(int v) {
+    int x;
+    return leaf_code(v, &x) == 0 ? x : -1;
+  }
+}
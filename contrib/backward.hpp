@@ -76,6 +76,10 @@
 #include <iomanip>
 #include <vector>
 
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
 #if defined(BACKWARD_SYSTEM_LINUX)
 
 // On linux, backtrace can back-trace or "walk" the stack using the following
@@ -94,6 +98,13 @@
 //  sadly really important in order to get perfectly accurate stack traces.
 //  - backtrace is part of the (e)glib library.
 //
+// #define BACKWARD_HAS_FP 1
+//  - walks the chain of saved frame pointers directly, checking every frame
+//  against the bounds of the thread's stack (and of the signal stack when
+//  running on one). Roughly an order of magnitude cheaper than unwind.
+//  - only sees frames built with -fno-omit-frame-pointer: the walk stops at
+//  the first function without one. x86, x86_64 and aarch64 only.
+//
 // The default is:
 // #define BACKWARD_HAS_UNWIND == 1
 //
@@ -101,6 +112,9 @@
 //
 #	if   BACKWARD_HAS_UNWIND == 1
 #	elif BACKWARD_HAS_BACKTRACE == 1
+#	elif BACKWARD_HAS_FP == 1
+#		undef  BACKWARD_HAS_UNWIND
+#		define BACKWARD_HAS_UNWIND 0
 #	else
 #		undef  BACKWARD_HAS_UNWIND
 #		define BACKWARD_HAS_UNWIND 1
@@ -189,6 +203,11 @@ extern "C" uintptr_t _Unwind_GetIPInfo(_Unwind_Context*, int*);
 #	include <syscall.h>
 #	include <unistd.h>
 #	include <signal.h>
+#	include <pthread.h>
+#	include <limits.h>
+#	include <stdint.h>
+#	include <errno.h>
+#	include <sys/mman.h>
 
 #	if BACKWARD_HAS_BFD == 1
 //              NOTE: defining PACKAGE{,_VERSION} is required before including
@@ -408,13 +427,16 @@ struct demangler_impl<system_tag::current_tag> {
 
 	std::string demangle(const char* funcname) {
 		using namespace details;
-		_demangle_buffer.reset(
-				abi::__cxa_demangle(funcname, _demangle_buffer.release(),
-					&_demangle_buffer_length, 0)
-				);
-		if (_demangle_buffer) {
-			return _demangle_buffer.get();
-		}
+		char* buffer = _demangle_buffer.release();
+		char* result = abi::__cxa_demangle(funcname, buffer,
+				&_demangle_buffer_length, 0);
+		if (result) {
+			// Maybe realloc()ed: buffer is only valid if it's the result.
+			_demangle_buffer.reset(result);
+			return result;
+		}
+		// Not a mangled name: the buffer is untouched and still ours.
+		_demangle_buffer.reset(buffer);
 		return funcname;
 	}
 
@@ -428,6 +450,14 @@ private:
 struct demangler:
 	public demangler_impl<system_tag::current_tag> {};
 
+// Set while SignalHandling handles a crash. Resolvers then only read what
+// was resolved before the crash and add nothing to what they share, and
+// frame pointer walks don't look up the thread's stack bounds.
+inline bool& in_crash_handler() {
+	static bool crashing = false;
+	return crashing;
+}
+
 } // namespace details
 
 /*************** A TRACE ***************/
@@ -555,8 +585,220 @@ protected:
 	std::vector<void*> _stacktrace;
 };
 
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#	define BACKWARD_FP_SUPPORTED 1
+#endif
 
-#if BACKWARD_HAS_UNWIND == 1
+#ifdef BACKWARD_FP_SUPPORTED
+
+namespace details {
+
+struct stack_bounds {
+	uintptr_t lo;
+	uintptr_t hi;
+
+	bool contains(uintptr_t p, size_t n) const {
+		return p >= lo && p < hi && hi - p >= n;
+	}
+};
+
+// Where SignalHandling's handler found the interrupted code's stack
+// pointer, 0 outside of it.
+inline uintptr_t& interrupted_stack_pointer() {
+	static __thread uintptr_t sp = 0;
+	return sp;
+}
+
+inline uintptr_t context_stack_pointer(const ucontext_t* uctx) {
+#if defined(__x86_64__)
+	return static_cast<uintptr_t>(uctx->uc_mcontext.gregs[REG_RSP]);
+#elif defined(__i386__)
+	return static_cast<uintptr_t>(uctx->uc_mcontext.gregs[REG_ESP]);
+#else
+	return static_cast<uintptr_t>(uctx->uc_mcontext.sp);
+#endif
+}
+
+extern "C" void* __libc_stack_end;
+
+// The stack of a thread that hadn't looked its bounds up before it crashed,
+// without pthread_getattr_np(): from the interrupted stack pointer to the
+// top glibc recorded for the main thread, or to the thread's descriptor,
+// which glibc keeps at the top of every other thread's stack.
+inline stack_bounds interrupted_stack_bounds() {
+	const uintptr_t lo = interrupted_stack_pointer();
+	const uintptr_t hi = syscall(SYS_gettid) == getpid()
+		? reinterpret_cast<uintptr_t>(__libc_stack_end)
+		: static_cast<uintptr_t>(pthread_self());
+	stack_bounds b = { lo, hi };
+	if (lo == 0 || hi <= lo) {
+		b.lo = b.hi = 0;
+	}
+	return b;
+}
+
+// pthread_getattr_np reads /proc/self/maps for the main thread and
+// allocates, so the result is kept per thread. A thread that crashes before
+// it looked them up gets interrupted_stack_bounds() instead.
+inline stack_bounds thread_stack_bounds() {
+	static __thread uintptr_t lo = 0;
+	static __thread uintptr_t hi = 0;
+	if (hi == 0 && in_crash_handler()) {
+		return interrupted_stack_bounds();
+	}
+	if (hi == 0) {
+		pthread_attr_t attr;
+		if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+			void*  addr = 0;
+			size_t size = 0;
+			if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+				lo = reinterpret_cast<uintptr_t>(addr);
+				hi = lo + size;
+			}
+			pthread_attr_destroy(&attr);
+		}
+	}
+	stack_bounds b = { lo, hi };
+	return b;
+}
+
+inline stack_bounds signal_stack_bounds() {
+	stack_t ss;
+	if (sigaltstack(0, &ss) == 0 && (ss.ss_flags & SS_ONSTACK)) {
+		stack_bounds b = { reinterpret_cast<uintptr_t>(ss.ss_sp),
+			reinterpret_cast<uintptr_t>(ss.ss_sp) + ss.ss_size };
+		return b;
+	}
+	stack_bounds none = { 0, 0 };
+	return none;
+}
+
+// Calls f(idx, call site) for up to depth frames, starting with the caller
+// of the function whose frame pointer is fp. Every frame is {saved frame
+// pointer, return address}. Callers' frames sit at higher addresses on the
+// same stack, except for the one jump from the signal stack back to the
+// thread's stack.
+template <typename F>
+size_t unwind_frame_pointers(F f, void* fp, size_t depth) {
+	const stack_bounds thread = thread_stack_bounds();
+	uintptr_t frame = reinterpret_cast<uintptr_t>(fp);
+	// sigaltstack() is a syscall, only ask when we aren't on our own stack.
+	const bool on_thread_stack = thread.contains(frame, 2 * sizeof(void*));
+	stack_bounds signal = { 0, 0 };
+	if (!on_thread_stack) {
+		signal = signal_stack_bounds();
+	}
+	bool on_signal_stack = !on_thread_stack
+		&& signal.contains(frame, 2 * sizeof(void*));
+	stack_bounds current = on_signal_stack ? signal : thread;
+
+	size_t idx = 0;
+	while (idx < depth) {
+		if (frame % sizeof(void*) != 0
+				|| !current.contains(frame, 2 * sizeof(void*))) {
+			break;
+		}
+		void* const* slots = reinterpret_cast<void* const*>(frame);
+		const uintptr_t ret = reinterpret_cast<uintptr_t>(slots[1]);
+		if (ret == 0) {
+			break;
+		}
+		f(idx++, reinterpret_cast<void*>(ret - 1));
+
+		const uintptr_t next = reinterpret_cast<uintptr_t>(slots[0]);
+		if (on_signal_stack && !signal.contains(next, 2 * sizeof(void*))) {
+			on_signal_stack = false;
+			current = thread;
+		} else if (next <= frame) {
+			break;
+		}
+		frame = next;
+	}
+	return idx;
+}
+
+// Whether the call site reported for a frame is the kernel's sigreturn
+// trampoline, i.e. the frame above it was interrupted by a signal.
+inline bool is_signal_trampoline(void* call_site) {
+	const unsigned char* code =
+		reinterpret_cast<const unsigned char*>(call_site) + 1;
+#if defined(__x86_64__)
+	// mov $SYS_rt_sigreturn, %rax; syscall
+	static const unsigned char restore_rt[] = {
+		0x48, 0xc7, 0xc0, 0x0f, 0x00, 0x00, 0x00, 0x0f, 0x05 };
+	return std::memcmp(code, restore_rt, sizeof(restore_rt)) == 0;
+#elif defined(__aarch64__)
+	// mov x8, #SYS_rt_sigreturn; svc #0
+	static const unsigned char restore_rt[] = {
+		0x68, 0x11, 0x80, 0xd2, 0x01, 0x00, 0x00, 0xd4 };
+	return std::memcmp(code, restore_rt, sizeof(restore_rt)) == 0;
+#else
+	(void)code;
+	return false;
+#endif
+}
+
+} // namespace details
+
+#endif // BACKWARD_FP_SUPPORTED
+
+
+#if BACKWARD_HAS_FP == 1
+
+#ifndef BACKWARD_FP_SUPPORTED
+#	error "BACKWARD_HAS_FP is only implemented for x86, x86_64 and aarch64."
+#endif
+
+template <>
+class StackTraceImpl<system_tag::linux_tag>: public StackTraceLinuxImplHolder {
+public:
+	__attribute__ ((noinline)) // TODO use some macro
+	size_t load_here(size_t depth=32) {
+		load_thread_info();
+		if (depth == 0) {
+			return 0;
+		}
+		_stacktrace.resize(depth);
+		size_t trace_cnt = details::unwind_frame_pointers(callback(*this),
+				__builtin_frame_address(0), depth);
+		_stacktrace.resize(trace_cnt);
+		skip_n_firsts(0);
+		return size();
+	}
+	size_t load_from(void* addr, size_t depth=32) {
+		load_here(depth + 8);
+
+		// The interrupted function's own frame isn't on the chain, only
+		// its caller's: addr takes the place of the signal trampoline.
+		for (size_t i = 0; i < _stacktrace.size(); ++i) {
+			if (_stacktrace[i] == addr) {
+				skip_n_firsts(i);
+				break;
+			}
+			if (details::is_signal_trampoline(_stacktrace[i])) {
+				_stacktrace[i] = addr;
+				skip_n_firsts(i);
+				break;
+			}
+		}
+
+		_stacktrace.resize(std::min(_stacktrace.size(),
+					skip_n_firsts() + depth));
+		return size();
+	}
+
+private:
+	struct callback {
+		StackTraceImpl& self;
+		callback(StackTraceImpl& self): self(self) {}
+
+		void operator()(size_t idx, void* addr) {
+			self._stacktrace[idx] = addr;
+		}
+	};
+};
+
+#elif BACKWARD_HAS_UNWIND == 1
 
 namespace details {
 
@@ -651,7 +893,7 @@ private:
 };
 
 
-#else // BACKWARD_HAS_UNWIND == 0
+#else // BACKWARD_HAS_UNWIND == 0 && BACKWARD_HAS_FP == 0
 
 template <>
 class StackTraceImpl<system_tag::linux_tag>: public StackTraceLinuxImplHolder {
@@ -686,7 +928,7 @@ public:
 	}
 };
 
-#endif // BACKWARD_HAS_UNWIND
+#endif // BACKWARD_HAS_FP, BACKWARD_HAS_UNWIND
 #endif // BACKWARD_SYSTEM_LINUX
 
 class StackTrace:
@@ -824,7 +1066,7 @@ public:
 				trace.addr, symbol_info.dli_fbase);
 		details_selected = &details_call_site;
 
-#if BACKWARD_HAS_UNWIND == 0
+#if BACKWARD_HAS_UNWIND == 0 && BACKWARD_HAS_FP != 1
 		// ...this is why we also try to resolve the symbol that is right
 		// before the return address. If we are lucky enough, we will get the
 		// line of the function that was called. But if the code is optimized,
@@ -1143,16 +1385,414 @@ private:
 
 #if BACKWARD_HAS_DW == 1
 
+namespace details {
+
+// An address -> function/file/line table of every object loaded in the
+// process, built once by preindex_symbols(). It only knows the outermost
+// function and the line table's source location, no inliners, but a lookup
+// is two binary searches instead of a walk through the DWARF.
+//
+// The names are copied into the index's own string table and the Dwfl is
+// let go once it's built. Rows of the line tables are kept only where the
+// file or line changes, 16 bytes each, and functions take 24 bytes: about
+// 1.1MB for the tests binary's 9.5k functions and 48k rows.
+class dw_index {
+public:
+	struct match {
+		const char* object;
+		const char* function;
+		const char* filename;
+		unsigned    line;
+	};
+
+	bool build() {
+		Dwfl_Callbacks callbacks;
+		callbacks.find_elf = &dwfl_linux_proc_find_elf;
+		callbacks.find_debuginfo = &dwfl_standard_find_debuginfo;
+		callbacks.section_address = 0;
+		callbacks.debuginfo_path = 0;
+		Dwfl* dwfl = dwfl_begin(&callbacks);
+		if (!dwfl) {
+			return false;
+		}
+		dwfl_report_begin(dwfl);
+		int r = dwfl_linux_proc_report(dwfl, getpid());
+		dwfl_report_end(dwfl, NULL, NULL);
+		if (r < 0) {
+			dwfl_end(dwfl);
+			return false;
+		}
+		// Offset 0 is "no string".
+		_strings.push_back('\0');
+		dwfl_getmodules(dwfl, &add_module, this, 0);
+		dwfl_end(dwfl);
+		hashtable<std::string, unsigned>::type().swap(_interned);
+
+		std::sort(_functions.begin(), _functions.end(), function_before);
+		// Of the rows at one address the last one counts, as in the line
+		// table itself.
+		std::stable_sort(_lines.begin(), _lines.end(), line_before);
+		compact_lines();
+		std::vector<function>(_functions).swap(_functions);
+		std::vector<char>(_strings).swap(_strings);
+		return true;
+	}
+
+	bool find(Dwarf_Addr addr, match& m) const {
+		std::vector<function>::const_iterator f = std::upper_bound(
+				_functions.begin(), _functions.end(), addr, addr_before_function);
+		if (f == _functions.begin() || addr >= (--f)->high) {
+			return false;
+		}
+		m.object = string_at(f->object);
+		m.function = string_at(f->name);
+		m.filename = 0;
+		m.line = 0;
+
+		std::vector<line>::const_iterator l = std::upper_bound(
+				_lines.begin(), _lines.end(), addr, addr_before_line);
+		if (l != _lines.begin() && (--l)->filename != 0) {
+			m.filename = string_at(l->filename);
+			m.line = l->line;
+		}
+		return true;
+	}
+
+private:
+	// Names are offsets into _strings.
+	struct function {
+		Dwarf_Addr low;
+		Dwarf_Addr high;
+		unsigned   name;
+		unsigned   object;
+	};
+
+	// Where a run of rows with the same file and line starts; filename is 0
+	// for the row ending a sequence.
+	struct line {
+		Dwarf_Addr addr;
+		unsigned   filename;
+		unsigned   line;
+	};
+
+	std::vector<function> _functions;
+	std::vector<line>     _lines;
+	std::vector<char>     _strings;
+	// Offsets of the object and file names, while building.
+	hashtable<std::string, unsigned>::type _interned;
+
+	const char* string_at(unsigned offset) const {
+		return offset ? &_strings[offset] : 0;
+	}
+
+	unsigned append(const char* s) {
+		const unsigned offset = static_cast<unsigned>(_strings.size());
+		_strings.insert(_strings.end(), s, s + strlen(s) + 1);
+		return offset;
+	}
+
+	unsigned intern(const char* s) {
+		if (!s) {
+			return 0;
+		}
+		std::pair<hashtable<std::string, unsigned>::type::iterator, bool> it =
+			_interned.insert(std::make_pair(std::string(s), 0u));
+		if (it.second) {
+			it.first->second = append(s);
+		}
+		return it.first->second;
+	}
+
+	// Keeps the last row at each address, then the first of each run with
+	// the same file and line: the lookup lands on it all the same.
+	void compact_lines() {
+		std::vector<line>::iterator out = _lines.begin();
+		for (std::vector<line>::iterator l = _lines.begin(); l != _lines.end(); ++l) {
+			if (l + 1 != _lines.end() && (l + 1)->addr == l->addr) {
+				continue;
+			}
+			if (out != _lines.begin() && (out - 1)->filename == l->filename
+					&& (out - 1)->line == l->line) {
+				continue;
+			}
+			*out++ = *l;
+		}
+		_lines.erase(out, _lines.end());
+		std::vector<line>(_lines).swap(_lines);
+	}
+
+	static bool function_before(const function& a, const function& b) {
+		return a.low < b.low;
+	}
+
+	// A sequence may start where another one ends: the end goes first so
+	// that upper_bound() - 1 lands on the start.
+	static bool line_before(const line& a, const line& b) {
+		return a.addr < b.addr || (a.addr == b.addr && !a.filename && b.filename);
+	}
+
+	static bool addr_before_function(Dwarf_Addr addr, const function& f) {
+		return addr < f.low;
+	}
+
+	static bool addr_before_line(Dwarf_Addr addr, const line& l) {
+		return addr < l.addr;
+	}
+
+	struct range {
+		Dwarf_Addr low;
+		Dwarf_Addr high;
+	};
+
+	static bool range_before(const range& a, const range& b) {
+		return a.low < b.low;
+	}
+
+	static bool addr_before_range(Dwarf_Addr addr, const range& r) {
+		return addr < r.low;
+	}
+
+	static bool within(const std::vector<range>& ranges, Dwarf_Addr addr) {
+		std::vector<range>::const_iterator r = std::upper_bound(
+				ranges.begin(), ranges.end(), addr, addr_before_range);
+		return r != ranges.begin() && addr < (--r)->high;
+	}
+
+	static int add_module(Dwfl_Module* mod, void**, const char* name,
+			Dwarf_Addr, void* arg) {
+		dw_index& self = *static_cast<dw_index*>(arg);
+
+		const unsigned object = self.intern(name);
+		const int nsyms = dwfl_module_getsymtab(mod);
+		for (int i = 1; i < nsyms; ++i) {
+			GElf_Sym sym;
+			const char* sym_name = dwfl_module_getsym(mod, i, &sym, 0);
+			if (sym_name && GELF_ST_TYPE(sym.st_info) == STT_FUNC
+					&& sym.st_value != 0 && sym.st_size != 0) {
+				function f = { sym.st_value, sym.st_value + sym.st_size,
+					self.append(sym_name), object };
+				self._functions.push_back(f);
+			}
+		}
+
+		// Where each sequence kept so far starts: CUs may share the code of
+		// an inline function, the first one describes it, as it does for
+		// dwfl_module_addrdie().
+		hashtable<Dwarf_Addr, bool>::type sequences;
+		Dwarf_Addr bias = 0;
+		Dwarf_Die* cudie = 0;
+		while ((cudie = dwfl_module_nextcu(mod, cudie, &bias))) {
+			Dwarf_Lines* lines = 0;
+			size_t nlines = 0;
+			if (dwarf_getsrclines(cudie, &lines, &nlines) != 0) {
+				continue;
+			}
+			std::vector<range> ranges;
+			Dwarf_Addr base = 0;
+			range r = { 0, 0 };
+			for (ptrdiff_t off = 0;
+					(off = dwarf_ranges(cudie, off, &base, &r.low, &r.high)) > 0;) {
+				ranges.push_back(r);
+			}
+			std::sort(ranges.begin(), ranges.end(), range_before);
+
+			// Rows mostly repeat the file of the row before.
+			const char* last_src = 0;
+			unsigned last_file = 0;
+			bool sequence_starts = true;
+			bool in_cu = false;
+			for (size_t i = 0; i < nlines; ++i) {
+				Dwarf_Line* srcloc = dwarf_onesrcline(lines, i);
+				Dwarf_Addr addr = 0;
+				int lineno = 0;
+				bool end_sequence = false;
+				if (!srcloc || dwarf_lineaddr(srcloc, &addr) != 0) {
+					continue;
+				}
+				dwarf_lineendsequence(srcloc, &end_sequence);
+				// A sequence outside the CU's own ranges is a copy of an
+				// inline function the linker dropped in favour of another
+				// CU's, as is one at 0.
+				if (sequence_starts) {
+					in_cu = addr != 0 && within(ranges, addr)
+						&& sequences.insert(std::make_pair(addr, true)).second;
+				}
+				sequence_starts = end_sequence;
+				if (!in_cu) {
+					continue;
+				}
+				line l = { addr + bias, 0, 0 };
+				if (!end_sequence) {
+					const char* src = dwarf_linesrc(srcloc, 0, 0);
+					if (src != last_src) {
+						last_src = src;
+						last_file = self.intern(src);
+					}
+					dwarf_lineno(srcloc, &lineno);
+					l.filename = last_file;
+					l.line = static_cast<unsigned>(lineno);
+				}
+				self._lines.push_back(l);
+			}
+		}
+		return DWARF_CB_OK;
+	}
+};
+
+// Shared by every libdw TraceResolver: traces resolved so far by address,
+// and the index once preindex_symbols() has built it. Never destroyed, the
+// indexing thread may still be running at exit.
+//
+// The cache allocates, so the crash handler only reads it, see
+// in_crash_handler().
+struct dw_shared_state {
+	static const size_t max_cached = 1 << 16;
+
+	pthread_mutex_t cache_lock;
+	hashtable<Dwarf_Addr, ResolvedTrace>::type cache;
+	dw_index* index; // published with __atomic_store_n once built
+	bool indexing;   // guarded by cache_lock
+
+	dw_shared_state(): index(0), indexing(false) {
+		pthread_mutex_init(&cache_lock, 0);
+	}
+
+	// The lock is only tried: resolving from a signal handler must not wait
+	// on a thread it interrupted.
+	bool find_cached(ResolvedTrace& trace) {
+		if (pthread_mutex_trylock(&cache_lock) != 0) {
+			return false;
+		}
+		hashtable<Dwarf_Addr, ResolvedTrace>::type::const_iterator it =
+			cache.find((Dwarf_Addr) trace.addr);
+		const bool found = it != cache.end();
+		if (found) {
+			const size_t idx = trace.idx;
+			trace = it->second;
+			trace.idx = idx;
+		}
+		pthread_mutex_unlock(&cache_lock);
+		return found;
+	}
+
+	void store(const ResolvedTrace& trace) {
+		if (pthread_mutex_trylock(&cache_lock) != 0) {
+			return;
+		}
+		if (cache.size() < max_cached) {
+			cache.insert(std::make_pair((Dwarf_Addr) trace.addr, trace));
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+
+	const dw_index* built_index() const {
+		return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+	}
+};
+
+inline dw_shared_state*& dw_shared_slot() {
+	static dw_shared_state* state = 0;
+	return state;
+}
+
+inline dw_shared_state* dw_publish_shared(dw_shared_state* state) {
+	__atomic_store_n(&dw_shared_slot(), state, __ATOMIC_RELEASE);
+	return state;
+}
+
+inline dw_shared_state& dw_shared() {
+	static dw_shared_state* state = dw_publish_shared(new dw_shared_state());
+	return *state;
+}
+
+// The shared state if something made it already, else 0. For the crash
+// handler, which must not be the one to make it.
+inline dw_shared_state* dw_shared_made() {
+	return __atomic_load_n(&dw_shared_slot(), __ATOMIC_ACQUIRE);
+}
+
+inline void* dw_build_index(void*) {
+	dw_index* index = new dw_index();
+	if (index->build()) {
+		__atomic_store_n(&dw_shared().index, index, __ATOMIC_RELEASE);
+	} else {
+		delete index;
+	}
+	return 0;
+}
+
+} // namespace details
+
 template <>
 class TraceResolverLinuxImpl<trace_resolver_tag::libdw>:
 	public TraceResolverLinuxImplBase {
 public:
-	TraceResolverLinuxImpl(): _dwfl_handle_initialized(false) {}
+	TraceResolverLinuxImpl(): _dwfl_handle_initialized(false),
+		_offline(false) {}
 
 	template <class ST>
 		void load_stacktrace(ST&) {}
 
+	// Resolves addresses of another process instead of this one: @p begin to
+	// @p end are {path, where its first segment was mapped} pairs, as in a
+	// RawCrashRecord.
+	template <class IT>
+		bool load_objects(IT begin, IT end) {
+			_offline = true;
+			_dwfl_handle_initialized = true;
+			_dwfl_cb.reset(new Dwfl_Callbacks);
+			_dwfl_cb->find_elf = &dwfl_linux_proc_find_elf;
+			_dwfl_cb->find_debuginfo = &dwfl_standard_find_debuginfo;
+			_dwfl_cb->section_address = 0;
+			_dwfl_cb->debuginfo_path = 0;
+
+			_dwfl_handle.reset(dwfl_begin(_dwfl_cb.get()));
+			if (!_dwfl_handle) {
+				return false;
+			}
+			dwfl_report_begin(_dwfl_handle.get());
+			for (; begin != end; ++begin) {
+				dwfl_report_elf(_dwfl_handle.get(), begin->first.c_str(),
+						begin->first.c_str(), -1, begin->second, false);
+			}
+			return dwfl_report_end(_dwfl_handle.get(), NULL, NULL) == 0;
+		}
+
+	// Each address is resolved once per process: from the cache, else the
+	// index if preindex_symbols() has finished building it, else the DWARF.
+	// In the crash handler nothing new is cached.
 	ResolvedTrace resolve(ResolvedTrace trace) {
+		if (_offline) {
+			return resolve_dwarf(trace);
+		}
+		const bool crashing = details::in_crash_handler();
+		details::dw_shared_state* shared =
+			crashing ? details::dw_shared_made() : &details::dw_shared();
+		if (shared && shared->find_cached(trace)) {
+			return trace;
+		}
+
+		details::dw_index::match m;
+		const details::dw_index* index = shared ? shared->built_index() : 0;
+		if (index && index->find((Dwarf_Addr) trace.addr, m)) {
+			trace.object_filename = m.object ? m.object : "";
+			trace.object_function = m.function ? demangle(m.function) : "";
+			trace.source.function = trace.object_function;
+			if (m.filename) {
+				trace.source.filename = m.filename;
+				trace.source.line = m.line;
+			}
+		} else {
+			trace = resolve_dwarf(trace);
+		}
+		if (!crashing) {
+			shared->store(trace);
+		}
+		return trace;
+	}
+
+private:
+	ResolvedTrace resolve_dwarf(ResolvedTrace trace) {
 		using namespace details;
 
 		Dwarf_Addr trace_addr = (Dwarf_Addr) trace.addr;
@@ -1309,6 +1949,7 @@ private:
 		           _dwfl_cb;
 	dwfl_handle_t  _dwfl_handle;
 	bool           _dwfl_handle_initialized;
+	bool           _offline;
 
 	// defined here because in C++98, template function cannot take locally
 	// defined types... grrr.
@@ -1487,54 +2128,106 @@ class TraceResolverImpl<system_tag::linux_tag>:
 class TraceResolver:
 	public TraceResolverImpl<system_tag::current_tag> {};
 
+// Starts building an address index of every loaded object in a background
+// thread, so that later symbolization (a crash trace from SignalHandling,
+// say) is a couple of lookups per frame instead of a walk through the DWARF.
+// Only the libdw resolver has one; returns false when there's nothing to
+// build or it's already being built.
+inline bool preindex_symbols() {
+#if defined(BACKWARD_SYSTEM_LINUX) && BACKWARD_HAS_DW == 1
+	details::dw_shared_state& shared = details::dw_shared();
+	pthread_mutex_lock(&shared.cache_lock);
+	const bool start = !shared.indexing;
+	shared.indexing = true;
+	pthread_mutex_unlock(&shared.cache_lock);
+	if (!start) {
+		return false;
+	}
+
+	pthread_t thread;
+	if (pthread_create(&thread, 0, &details::dw_build_index, 0) != 0) {
+		return false;
+	}
+	pthread_detach(thread);
+	return true;
+#else
+	return false;
+#endif
+}
+
 /*************** CODE SNIPPET ***************/
 
+namespace details {
+
+// Appends the offset of every line's first character to starts. A newline
+// ending the data doesn't start another line, the same as for getline().
+inline void index_lines(const char* data, size_t size,
+		std::vector<size_t>& starts) {
+	if (size == 0) {
+		return;
+	}
+	starts.push_back(0);
+	size_t i = 0;
+#ifdef __SSE2__
+	const __m128i newline = _mm_set1_epi8('\n');
+	for (; i + 16 <= size; i += 16) {
+		const __m128i chunk = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(data + i));
+		unsigned mask = static_cast<unsigned>(
+				_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+		while (mask) {
+			starts.push_back(i + static_cast<size_t>(__builtin_ctz(mask)) + 1);
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for (; i < size; ++i) {
+		if (data[i] == '\n') {
+			starts.push_back(i + 1);
+		}
+	}
+	if (starts.back() == size) {
+		starts.pop_back();
+	}
+}
+
+} // namespace details
+
+// A source file read once (mapped on Linux) with an index of where each line
+// starts, built on the first get_lines(), so that every snippet after that
+// costs only the lines it returns.
 class SourceFile {
 public:
 	typedef std::vector<std::pair<unsigned, std::string> > lines_t;
 
-	SourceFile() {}
-	SourceFile(const std::string& path): _file(new std::ifstream(path.c_str())) {}
-	bool is_open() const { return _file->is_open(); }
+	SourceFile(): _data(0), _size(0), _open(false), _indexed(false) {}
+	SourceFile(const std::string& path):
+		_data(0), _size(0), _open(false), _indexed(false) {
+		load(path);
+	}
+	~SourceFile() {
+		unload();
+	}
+	bool is_open() const { return _open; }
 
 	lines_t& get_lines(unsigned line_start, unsigned line_count, lines_t& lines) {
-		using namespace std;
-		// This function make uses of the dumbest algo ever:
-		//	1) seek(0)
-		//	2) read lines one by one and discard until line_start
-		//	3) read line one by one until line_start + line_count
-		//
-		// If you are getting snippets many time from the same file, it is
-		// somewhat a waste of CPU, feel free to benchmark and propose a
-		// better solution ;)
-
-		_file->clear();
-		_file->seekg(0);
-		string line;
-		unsigned line_idx;
-
-		for (line_idx = 1; line_idx < line_start; ++line_idx) {
-			std::getline(*_file, line);
-			if (!*_file) {
-				return lines;
-			}
+		if (!_indexed) {
+			details::index_lines(_data, _size, _line_starts);
+			_indexed = true;
 		}
 
-		// think of it like a lambda in C++98 ;)
-		// but look, I will reuse it two times!
-		// What a good boy am I.
-		struct isspace {
-			bool operator()(char c) {
-				return std::isspace(c);
-			}
-		};
+		// Lines are numbered from 1. line_start can be 0, or wrapped around
+		// by callers centering a snippet on the first lines.
+		if (line_start > _line_starts.size()) {
+			return lines;
+		}
+		unsigned line_idx = line_start ? line_start : 1;
+		const unsigned line_end = static_cast<unsigned>(std::min<size_t>(
+					_line_starts.size() + 1, line_start + line_count));
 
 		bool started = false;
-		for (; line_idx < line_start + line_count; ++line_idx) {
-			getline(*_file, line);
-			if (!*_file) {
-				return lines;
-			}
+		for (; line_idx < line_end; ++line_idx) {
+			std::string line = get_line(line_idx);
 			if (!started) {
 				if (std::find_if(line.begin(), line.end(),
 							not_isspace()) == line.end())
@@ -1573,18 +2266,29 @@ public:
 	};
 
 	void swap(SourceFile& b) {
-		_file.swap(b._file);
+		std::swap(_data, b._data);
+		std::swap(_size, b._size);
+		std::swap(_open, b._open);
+		std::swap(_indexed, b._indexed);
+		_line_starts.swap(b._line_starts);
+#ifndef BACKWARD_SYSTEM_LINUX
+		_contents.swap(b._contents);
+		_data = _contents.data();
+		b._data = b._contents.data();
+#endif
 	}
 
 #ifdef BACKWARD_ATLEAST_CXX11
-	SourceFile(SourceFile&& from): _file(0) {
+	SourceFile(SourceFile&& from):
+		_data(0), _size(0), _open(false), _indexed(false) {
 		swap(from);
 	}
 	SourceFile& operator=(SourceFile&& from) {
 		swap(from); return *this;
 	}
 #else
-	explicit SourceFile(const SourceFile& from) {
+	explicit SourceFile(const SourceFile& from):
+		_data(0), _size(0), _open(false), _indexed(false) {
 		// some sort of poor man's move semantic.
 		swap(const_cast<SourceFile&>(from));
 	}
@@ -1595,9 +2299,68 @@ public:
 #endif
 
 private:
-	details::handle<std::ifstream*,
-		details::default_delete<std::ifstream*>
-			> _file;
+	const char*         _data;
+	size_t              _size;
+	bool                _open;
+	bool                _indexed;
+	std::vector<size_t> _line_starts;
+#ifndef BACKWARD_SYSTEM_LINUX
+	std::string         _contents;
+#endif
+
+	std::string get_line(unsigned line_idx) const {
+		const size_t begin = _line_starts[line_idx - 1];
+		size_t end = line_idx < _line_starts.size()
+			? _line_starts[line_idx] - 1 : _size;
+		if (end > begin && _data[end - 1] == '\n') {
+			end -= 1;
+		}
+		return std::string(_data + begin, _data + end);
+	}
+
+#ifdef BACKWARD_SYSTEM_LINUX
+	void load(const std::string& path) {
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+			_open = true;
+			_size = static_cast<size_t>(st.st_size);
+			if (_size) {
+				void* map = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (map == MAP_FAILED) {
+					_open = false;
+					_size = 0;
+				} else {
+					_data = static_cast<const char*>(map);
+				}
+			}
+		}
+		close(fd);
+	}
+
+	void unload() {
+		if (_data) {
+			munmap(const_cast<char*>(_data), _size);
+		}
+	}
+#else
+	void load(const std::string& path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			return;
+		}
+		_contents.assign(std::istreambuf_iterator<char>(file),
+				std::istreambuf_iterator<char>());
+		_data = _contents.data();
+		_size = _contents.size();
+		_open = true;
+	}
+
+	void unload() {}
+#endif
 
 #ifdef BACKWARD_ATLEAST_CXX11
 	SourceFile(const SourceFile&) = delete;
@@ -1865,6 +2628,237 @@ private:
 	}
 };
 
+/*************** RAW CRASH RECORDS ***************/
+
+#ifdef BACKWARD_SYSTEM_LINUX
+
+// What SignalHandling writes instead of a report when given a path with
+// write_raw_records_to(), all in the crashing machine's byte order:
+//
+//   raw_crash_header
+//   uint64_t frames[frame_count]       innermost first
+//   for each object mapped from file offset 0:
+//     uint64_t base                    where it was mapped
+//     uint32_t path_len
+//     char     path[path_len]
+//   uint64_t 0, uint32_t 0
+//
+// Writing it takes open(), read() of /proc/self/maps, write() and close(),
+// no allocation or locks, and only the stack walk reaches outside the
+// handler. tools/symbolize turns it back into the usual report.
+
+namespace details {
+
+struct raw_crash_header {
+	char     magic[8];
+	uint32_t version;
+	int32_t  signo;
+	int32_t  code;
+	int32_t  pid;
+	int32_t  tid;
+	uint32_t frame_count;
+	uint64_t fault_addr;
+};
+
+static const char     raw_crash_magic[8] = { 'B', 'W', 'C', 'R', 'A', 'S', 'H', 0 };
+static const uint32_t raw_crash_version = 1;
+static const size_t   raw_crash_max_frames = 64;
+
+struct raw_collect {
+	void** frames;
+	raw_collect(void** f): frames(f) {}
+
+	void operator()(size_t idx, void* addr) {
+		frames[idx] = addr;
+	}
+};
+
+// StackTrace::load_from() into a caller's array: the frames from the one
+// at error_addr outwards, or all of them if it isn't found.
+inline size_t raw_stack_from(void* error_addr, void** frames, size_t depth) {
+#if BACKWARD_HAS_FP == 1
+	size_t n = unwind_frame_pointers(raw_collect(frames),
+			__builtin_frame_address(0), depth);
+#elif BACKWARD_HAS_UNWIND == 1
+	size_t n = unwind(raw_collect(frames), depth);
+#else
+	size_t n = static_cast<size_t>(backtrace(frames, static_cast<int>(depth)));
+#endif
+	for (size_t i = 0; i < n; ++i) {
+		bool found = frames[i] == error_addr;
+#if BACKWARD_HAS_FP == 1
+		if (!found && error_addr && is_signal_trampoline(frames[i])) {
+			frames[i] = error_addr;
+			found = true;
+		}
+#endif
+		if (found) {
+			std::memmove(frames, frames + i, (n - i) * sizeof(void*));
+			return n - i;
+		}
+	}
+	return n;
+}
+
+inline bool raw_write(int fd, const void* data, size_t size) {
+	const char* p = static_cast<const char*>(data);
+	while (size > 0) {
+		ssize_t r = write(fd, p, size);
+		if (r < 0 && errno == EINTR) {
+			continue;
+		}
+		if (r <= 0) {
+			return false;
+		}
+		p += r;
+		size -= static_cast<size_t>(r);
+	}
+	return true;
+}
+
+inline uint64_t raw_parse_hex(const char*& p, const char* end) {
+	uint64_t v = 0;
+	for (; p != end; ++p) {
+		const char c = *p;
+		if (c >= '0' && c <= '9') {
+			v = v * 16 + static_cast<uint64_t>(c - '0');
+		} else if (c >= 'a' && c <= 'f') {
+			v = v * 16 + static_cast<uint64_t>(c - 'a' + 10);
+		} else {
+			break;
+		}
+	}
+	return v;
+}
+
+inline void raw_skip_field(const char*& p, const char* end) {
+	while (p != end && *p != ' ') {
+		++p;
+	}
+	while (p != end && *p == ' ') {
+		++p;
+	}
+}
+
+// "start-end perms offset dev inode   path"
+inline bool raw_write_object(int fd, const char* line, size_t len) {
+	const char* p = line;
+	const char* end = line + len;
+	const uint64_t base = raw_parse_hex(p, end);
+	raw_skip_field(p, end); // -end
+	raw_skip_field(p, end); // perms
+	if (raw_parse_hex(p, end) != 0) {
+		return true;
+	}
+	raw_skip_field(p, end); // offset
+	raw_skip_field(p, end); // dev
+	raw_skip_field(p, end); // inode
+	if (p == end || *p != '/') {
+		return true;
+	}
+	const uint32_t path_len = static_cast<uint32_t>(end - p);
+	return raw_write(fd, &base, sizeof base)
+		&& raw_write(fd, &path_len, sizeof path_len)
+		&& raw_write(fd, p, path_len);
+}
+
+inline bool raw_write_objects(int fd) {
+	const int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+	if (maps < 0) {
+		return false;
+	}
+	char   buf[4096];
+	char   line[PATH_MAX + 128];
+	size_t len = 0;
+	bool   overlong = false;
+	bool   ok = true;
+	for (;;) {
+		ssize_t n = read(maps, buf, sizeof buf);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		for (ssize_t i = 0; i < n && ok; ++i) {
+			if (buf[i] != '\n') {
+				if (len < sizeof line) {
+					line[len++] = buf[i];
+				} else {
+					overlong = true;
+				}
+				continue;
+			}
+			if (!overlong) {
+				ok = raw_write_object(fd, line, len);
+			}
+			len = 0;
+			overlong = false;
+		}
+	}
+	close(maps);
+	return ok;
+}
+
+} // namespace details
+
+// A record written by SignalHandling in raw mode, read back.
+struct RawCrashRecord {
+	details::raw_crash_header header;
+	std::vector<void*>        frames;
+	// {path, where its first segment was mapped}
+	std::vector<std::pair<std::string, uintptr_t> > objects;
+
+	bool load(const char* path) {
+		FILE* f = fopen(path, "rb");
+		if (!f) {
+			return false;
+		}
+		const bool ok = read(f);
+		fclose(f);
+		return ok;
+	}
+
+private:
+	bool read(FILE* f) {
+		if (fread(&header, sizeof header, 1, f) != 1
+				|| memcmp(header.magic, details::raw_crash_magic,
+					sizeof header.magic) != 0
+				|| header.version != details::raw_crash_version
+				|| header.frame_count > details::raw_crash_max_frames) {
+			return false;
+		}
+		frames.clear();
+		for (uint32_t i = 0; i < header.frame_count; ++i) {
+			uint64_t addr;
+			if (fread(&addr, sizeof addr, 1, f) != 1) {
+				return false;
+			}
+			frames.push_back(reinterpret_cast<void*>(static_cast<uintptr_t>(addr)));
+		}
+		objects.clear();
+		for (;;) {
+			uint64_t base;
+			uint32_t path_len;
+			if (fread(&base, sizeof base, 1, f) != 1
+					|| fread(&path_len, sizeof path_len, 1, f) != 1
+					|| path_len > PATH_MAX) {
+				return false;
+			}
+			if (base == 0 && path_len == 0) {
+				return true;
+			}
+			std::string object(path_len, '\0');
+			if (path_len && fread(&object[0], path_len, 1, f) != 1) {
+				return false;
+			}
+			objects.push_back(std::make_pair(object, static_cast<uintptr_t>(base)));
+		}
+	}
+};
+
+#endif // BACKWARD_SYSTEM_LINUX
+
 /*************** SIGNALS HANDLING ***************/
 
 #ifdef BACKWARD_SYSTEM_LINUX
@@ -1941,14 +2935,81 @@ public:
 
 	bool loaded() const { return _loaded; }
 
+	// From now on the handler doesn't resolve and print the trace, which
+	// allocates and takes locks, but writes a RawCrashRecord to @p path:
+	// the frames' addresses, where each object was loaded, the signal and
+	// the thread. tools/symbolize makes the report from it. Returns false if
+	// @p path is too long.
+	static bool write_raw_records_to(const char* path) {
+		const size_t len = strlen(path);
+		if (len >= PATH_MAX) {
+			return false;
+		}
+		// Gets the unwinder loaded and this thread's stack bounds cached
+		// here rather than in the handler.
+		void* frames[details::raw_crash_max_frames];
+		details::raw_stack_from(0, frames, details::raw_crash_max_frames);
+		memcpy(raw_record_path(), path, len + 1);
+		return true;
+	}
+
 private:
 	details::handle<char*> _stack_content;
 	bool                   _loaded;
 
+	static char* raw_record_path() {
+		static char path[PATH_MAX];
+		return path;
+	}
+
+	static void write_raw_record(siginfo_t* info, void* error_addr) {
+		const int fd = open(raw_record_path(),
+				O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			return;
+		}
+		void* frames[details::raw_crash_max_frames];
+		const size_t n = details::raw_stack_from(error_addr, frames,
+				details::raw_crash_max_frames);
+
+		details::raw_crash_header header;
+		memset(&header, 0, sizeof header);
+		memcpy(header.magic, details::raw_crash_magic, sizeof header.magic);
+		header.version = details::raw_crash_version;
+		header.signo = info->si_signo;
+		header.code = info->si_code;
+		header.pid = getpid();
+		header.tid = static_cast<int32_t>(syscall(SYS_gettid));
+		header.frame_count = static_cast<uint32_t>(n);
+		header.fault_addr = reinterpret_cast<uintptr_t>(info->si_addr);
+
+		uint64_t addrs[details::raw_crash_max_frames];
+		for (size_t i = 0; i < n; ++i) {
+			addrs[i] = reinterpret_cast<uintptr_t>(frames[i]);
+		}
+		const uint64_t no_base = 0;
+		const uint32_t no_path = 0;
+		const bool ok = details::raw_write(fd, &header, sizeof header)
+			&& details::raw_write(fd, addrs, n * sizeof addrs[0])
+			&& details::raw_write_objects(fd)
+			&& details::raw_write(fd, &no_base, sizeof no_base)
+			&& details::raw_write(fd, &no_path, sizeof no_path);
+		close(fd);
+
+		static const char written[] = "Crash record written to ";
+		static const char failed[] = "Failed to write crash record to ";
+		if (ok) {
+			details::raw_write(2, written, sizeof written - 1);
+		} else {
+			details::raw_write(2, failed, sizeof failed - 1);
+		}
+		details::raw_write(2, raw_record_path(), strlen(raw_record_path()));
+		details::raw_write(2, "\n", 1);
+	}
+
 	static void sig_handler(int, siginfo_t* info, void* _ctx) {
 		ucontext_t *uctx = (ucontext_t*) _ctx;
 
-		StackTrace st;
 		void* error_addr = 0;
 #ifdef REG_RIP // x86_64
 		error_addr = reinterpret_cast<void*>(uctx->uc_mcontext.gregs[REG_RIP]);
@@ -1961,19 +3022,29 @@ private:
 #else
 #	warning ":/ sorry, ain't know no nothing none not of your architecture!"
 #endif
-		if (error_addr) {
-			st.load_from(error_addr, 32);
+#ifdef BACKWARD_FP_SUPPORTED
+		details::interrupted_stack_pointer() =
+			details::context_stack_pointer(uctx);
+#endif
+		details::in_crash_handler() = true;
+		if (raw_record_path()[0]) {
+			write_raw_record(info, error_addr);
 		} else {
-			st.load_here(32);
-		}
+			StackTrace st;
+			if (error_addr) {
+				st.load_from(error_addr, 32);
+			} else {
+				st.load_here(32);
+			}
 
-		Printer printer;
-		printer.address = true;
-		printer.print(st, stderr);
+			Printer printer;
+			printer.address = true;
+			printer.print(st, stderr);
 
 #if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L
-		psiginfo(info, 0);
+			psiginfo(info, 0);
 #endif
+		}
 
 		// try to forward the signal.
 		raise(info->si_signo);
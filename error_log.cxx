@@ -0,0 +1,293 @@
+/*
+ * error_log.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "error_log.hpp"
+#include "thread_slot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <limits.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace{
+  using util::errlog::burst;
+  using util::errlog::message_size;
+  using util::errlog::ring_capacity;
+
+  static_assert((ring_capacity & (ring_capacity - 1)) == 0, "ring_capacity must be a power of two.");
+
+  using clock_type = std::chrono::steady_clock;
+
+  struct record {
+    const char* file;
+    unsigned line;
+    unsigned length;
+    char message[message_size];
+  };
+
+  // One per thread (see thread_slot). One producer, the owning thread, and
+  // one consumer, whoever holds drain_lock.
+  struct ring {
+    record slots[ring_capacity];
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::uint64_t> tail{0};
+    std::atomic<std::uint64_t> dropped{0};
+  };
+
+  using rings = util::details::thread_slot<ring>;
+
+  std::atomic<int> out_fd{2};
+  std::atomic<std::uint64_t> written{0};
+  std::atomic<std::uint64_t> suppressed{0};
+
+  // Everything below is only touched under drain_lock.
+  std::mutex drain_lock;
+
+  struct site_key {
+    const char* file;
+    unsigned line;
+    std::string message;
+
+    bool operator==(const site_key& o) const {
+      return file == o.file && line == o.line && message == o.message;
+    }
+  };
+
+  struct site_key_hash {
+    std::size_t operator()(const site_key& k) const {
+      return std::hash<std::string>()(k.message) ^
+             (std::hash<const char*>()(k.file) * 31 + k.line);
+    }
+  };
+
+  struct window {
+    clock_type::time_point start;
+    unsigned count;
+    std::uint64_t suppressed;
+  };
+
+  std::unordered_map<site_key, window, site_key_hash> windows;
+  clock_type::time_point last_sweep;
+  std::vector<std::string> lines;
+
+  void add_line(const site_key& k, std::uint64_t suppressed_count) {
+    std::string line = k.file;
+    line += ':';
+    line += std::to_string(k.line);
+    line += ": ";
+    line += k.message;
+    if(suppressed_count != 0){
+      line += " [";
+      line += std::to_string(suppressed_count);
+      line += " more suppressed]";
+    }
+    line += '\n';
+    lines.push_back(std::move(line));
+  }
+
+  void admit(const record& rec, clock_type::time_point now) {
+    site_key k{rec.file, rec.line, std::string(rec.message, rec.length)};
+    auto it = windows.find(k);
+    if(it == windows.end()){
+      add_line(k, 0);
+      windows.emplace(std::move(k), window{now, 1, 0});
+      return;
+    }
+    window& w = it->second;
+    if(now - w.start >= std::chrono::seconds(1)){
+      if(w.suppressed != 0){
+        add_line(it->first, w.suppressed);
+      }
+      w = window{now, 0, 0};
+    }
+    if(w.count < burst){
+      ++w.count;
+      add_line(it->first, 0);
+    } else {
+      ++w.suppressed;
+      suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Sums up the windows that are over, or all of them when flushing.
+  void sweep(clock_type::time_point now, bool all) {
+    for(auto it = windows.begin(); it != windows.end();){
+      window& w = it->second;
+      const bool over = now - w.start >= std::chrono::seconds(1);
+      if((over || all) && w.suppressed != 0){
+        add_line(it->first, w.suppressed);
+        w.suppressed = 0;
+      }
+      if(over){
+        it = windows.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    last_sweep = now;
+  }
+
+  void write_lines() {
+    const int fd = out_fd.load(std::memory_order_relaxed);
+    std::vector<iovec> iov;
+    iov.reserve(std::min<std::size_t>(lines.size(), IOV_MAX));
+    for(std::size_t first = 0; first < lines.size();){
+      iov.clear();
+      for(std::size_t i = first; i < lines.size() && iov.size() < IOV_MAX; ++i){
+        iov.push_back({&lines[i][0], lines[i].size()});
+      }
+      first += iov.size();
+
+      // Lines that went out whole. On a write error the rest of the batch
+      // is lost and isn't counted.
+      std::uint64_t done = 0;
+      iovec* next = iov.data();
+      int left = static_cast<int>(iov.size());
+      while(left > 0){
+        ssize_t n = ::writev(fd, next, left);
+        if(n < 0 && errno == EINTR){
+          continue;
+        }
+        if(n <= 0){
+          break;
+        }
+        // Partial write: skip what went out and carry on from there.
+        while(left > 0 && static_cast<std::size_t>(n) >= next->iov_len){
+          n -= static_cast<ssize_t>(next->iov_len);
+          ++next;
+          --left;
+          ++done;
+        }
+        if(left > 0){
+          next->iov_base = static_cast<char*>(next->iov_base) + n;
+          next->iov_len -= static_cast<std::size_t>(n);
+        }
+      }
+      written.fetch_add(done, std::memory_order_relaxed);
+    }
+    lines.clear();
+  }
+
+  std::size_t drain(bool flushing) {
+    const clock_type::time_point now = clock_type::now();
+    std::size_t n = 0;
+    rings::for_each([&](ring& r) {
+      std::uint64_t tail       = r.tail.load(std::memory_order_relaxed);
+      const std::uint64_t head = r.head.load(std::memory_order_acquire);
+      for(; tail != head; ++tail, ++n){
+        admit(r.slots[tail & (ring_capacity - 1)], now);
+      }
+      r.tail.store(tail, std::memory_order_release);
+    });
+    if(flushing || now - last_sweep >= std::chrono::seconds(1)){
+      sweep(now, flushing);
+    }
+    write_lines();
+    return n;
+  }
+
+  std::atomic<bool> writer_started{false};
+  std::atomic<bool> stopping{false};
+  pthread_t writer;
+
+  void* write_loop(void*) {
+    // Backs off while there's nothing to write.
+    unsigned idle_us = 50;
+    while(!stopping.load(std::memory_order_acquire)){
+      std::size_t n;
+      {
+        std::lock_guard<std::mutex> lock(drain_lock);
+        n = drain(false);
+      }
+      if(n != 0){
+        idle_us = 50;
+      } else {
+        ::usleep(idle_us);
+        idle_us = std::min(idle_us * 2, 10000u);
+      }
+    }
+    return nullptr;
+  }
+
+  void start_writer() noexcept {
+    bool started = false;
+    if(writer_started.compare_exchange_strong(started, true, std::memory_order_acq_rel)){
+      if(pthread_create(&writer, nullptr, &write_loop, nullptr) != 0){
+        writer_started.store(false, std::memory_order_release);
+      }
+    }
+  }
+
+  // Declared last, so destroyed first: stops the writer and writes what's
+  // left at exit.
+  struct writer_stopper {
+    ~writer_stopper() {
+      if(writer_started.load(std::memory_order_acquire)){
+        stopping.store(true, std::memory_order_release);
+        pthread_join(writer, nullptr);
+      }
+      util::errlog::flush();
+    }
+  } writer_stopper_;
+}
+
+namespace util {
+  namespace errlog {
+    void push(const char* file, unsigned line, const char* message) noexcept {
+      ring* mine = rings::get();
+      if(mine == nullptr){
+        return;
+      }
+      ring& r = *mine;
+      const std::uint64_t head = r.head.load(std::memory_order_relaxed);
+      if(head - r.tail.load(std::memory_order_acquire) == ring_capacity){
+        r.dropped.store(r.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+      }
+      record& rec = r.slots[head & (ring_capacity - 1)];
+      rec.file    = file;
+      rec.line    = line;
+      rec.length  = static_cast<unsigned>(::strnlen(message, message_size));
+      std::memcpy(rec.message, message, rec.length);
+      r.head.store(head + 1, std::memory_order_release);
+
+      if(!writer_started.load(std::memory_order_relaxed)){
+        start_writer();
+      }
+    }
+
+    void set_output(int fd) noexcept {
+      out_fd.store(fd, std::memory_order_relaxed);
+    }
+
+    void flush() {
+      std::lock_guard<std::mutex> lock(drain_lock);
+      drain(true);
+    }
+
+    counters stats() noexcept {
+      counters c{0, written.load(std::memory_order_relaxed),
+                 suppressed.load(std::memory_order_relaxed), 0};
+      rings::for_each([&](const ring& r) {
+        c.logged += r.head.load(std::memory_order_relaxed);
+        c.dropped += r.dropped.load(std::memory_order_relaxed);
+      });
+      return c;
+    }
+  } // namespace errlog
+} // namespace util
@@ -0,0 +1,89 @@
+/*
+ * error_log.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef ERROR_LOG_HPP_K7DW2Q5N
+#define ERROR_LOG_HPP_K7DW2Q5N
+
+// Logging for errors that are handled rather than aborted on:
+//
+//   auto cfg = load_config(path);
+//   util::log_if_err(cfg);
+//
+// log_if_err() copies the call site and the error's context (get_context(),
+// when E has one) into a ring owned by the calling thread and returns,
+// without locking or doing I/O; when the ring is full the record is
+// dropped and counted. Only a thread's first record allocates: its ring,
+// about 32 KiB, reused by later threads once it exits. The process's first
+// record also starts a background thread, which drains every ring and
+// writes "file:line: context" lines to stderr (or set_output()) with
+// writev. Past burst lines per second from one site
+// with the same context, the rest are suppressed and summed up in one line
+// when the second is over.
+
+#include "result.hpp"
+#include "result_stats.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+  namespace errlog {
+    // Records kept per thread until the writer gets to them.
+    constexpr unsigned ring_capacity = 256;
+    // Longer contexts are truncated.
+    constexpr unsigned message_size = 112;
+    // Identical lines written per site and second.
+    constexpr unsigned burst = 10;
+
+    struct counters {
+      std::uint64_t logged;     // records pushed
+      std::uint64_t written;    // lines that made it out, all of them
+      std::uint64_t suppressed; // records over the burst
+      std::uint64_t dropped;    // records that found their ring full
+    };
+
+    void push(const char* file, unsigned line, const char* message) noexcept;
+
+    // Where lines go, stderr by default.
+    void set_output(int fd) noexcept;
+
+    // Writes everything pushed so far before returning, including pending
+    // suppression summaries.
+    void flush();
+
+    counters stats() noexcept;
+  } // namespace errlog
+
+  namespace details {
+    template<typename E>
+    auto errlog_message(const E& e, int) -> decltype(get_context(e)) {
+      return get_context(e);
+    }
+
+    template<typename E>
+    const char* errlog_message(const E&, long) {
+      return "error without context";
+    }
+  } // namespace details
+
+  /**
+   *  Logs @p res's error, if it has one, from the calling thread's ring.
+   *  Returns whether it did.
+   */
+  template<typename T, typename E>
+  bool log_if_err(const Result<T, E>& res,
+                  stats::site site = stats::site::current()) {
+    if (!res.is_err()) {
+      return false;
+    }
+    errlog::push(site.file, site.line, details::errlog_message(res.err(), 0));
+    return true;
+  }
+} // namespace util
+
+#endif /* end of include guard: ERROR_LOG_HPP_K7DW2Q5N */
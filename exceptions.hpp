@@ -0,0 +1,153 @@
+/*
+ * exceptions.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef EXCEPTIONS_HPP_Q4N8ZC1W
+#define EXCEPTIONS_HPP_Q4N8ZC1W
+
+#include "result.hpp"
+
+#if !RESULT_EXCEPTIONS
+#error "exceptions.hpp requires exception support."
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+  /**
+   *  Error produced by catch_as_result(): the caught exception, which of the
+   *  selected types matched, and its what() if it is a std::exception.
+   */
+  struct caught_exception {
+    std::exception_ptr ptr;
+    // Owned by the exception, which ptr keeps alive.
+    const char* what = nullptr;
+    std::size_t index = 0;
+
+    [[noreturn]] void rethrow() const {
+      std::rethrow_exception(ptr);
+    }
+
+    friend const char* get_context(const caught_exception& e) {
+      return e.what ? e.what : "Unknown exception.";
+    }
+  };
+
+  /**
+   *  Thrown by into_exception() for errors that aren't exceptions themselves.
+   */
+  template<typename E>
+  struct result_error : std::exception {
+    E error;
+
+    explicit result_error(E e)
+      : error(std::move(e)) {
+    }
+
+    const char* what() const noexcept override {
+      return "util::Result contained an error.";
+    }
+  };
+
+  namespace details {
+    template<typename E>
+    const char* exception_what(const E& e, std::true_type /*is exception*/) {
+      return e.what();
+    }
+
+    template<typename E>
+    const char* exception_what(const E&, std::false_type) {
+      return nullptr;
+    }
+
+    // Layer I catches the (I-1)th type around layer I-1, so the innermost
+    // handler is for the first type listed. Like a sequence of catch
+    // clauses, the first matching type wins.
+    template<std::size_t I, typename... Es>
+    struct catch_layer {
+      using E = std::tuple_element_t<I - 1, std::tuple<Es...>>;
+
+      template<typename R, typename F>
+      static R run(F& fn) {
+        try {
+          return catch_layer<I - 1, Es...>::template run<R>(fn);
+        } catch (const E& e) {
+          return Err(caught_exception{
+            std::current_exception(),
+            exception_what(e, std::is_base_of<std::exception, E>{}),
+            I - 1});
+        }
+      }
+    };
+
+    template<typename... Es>
+    struct catch_layer<0, Es...> {
+      template<typename R, typename F>
+      static R run(F& fn) {
+        return Ok(fn());
+      }
+    };
+
+    template<typename E>
+    [[noreturn]] void throw_error(E&& e, std::true_type /*is exception*/) {
+      throw std::forward<E>(e);
+    }
+
+    template<typename E>
+    [[noreturn]] void throw_error(E&& e, std::false_type) {
+      throw result_error<std::decay_t<E>>(std::forward<E>(e));
+    }
+
+    [[noreturn]] inline void throw_error(caught_exception&& e) {
+      e.rethrow();
+    }
+
+    template<typename E>
+    [[noreturn]] void throw_error(E&& e) {
+      throw_error(std::forward<E>(e),
+                  std::is_base_of<std::exception, std::decay_t<E>>{});
+    }
+  } // namespace details
+
+  /**
+   *  Calls @p fn, turning any exception of the types @p Es into an Err.
+   *  Other exceptions propagate. Exceptions are caught by reference and the
+   *  success path doesn't allocate.
+   *
+   *  auto r = util::catch_as_result<std::ios_base::failure>([&] {
+   *    return parse(stream);
+   *  });
+   */
+  template<typename... Es, typename F>
+  auto catch_as_result(F&& fn)
+    -> Result<decltype(std::declval<F&>()()), caught_exception> {
+    static_assert(sizeof...(Es) > 0,
+                  "catch_as_result needs at least one exception type.");
+    using R = Result<decltype(std::declval<F&>()()), caught_exception>;
+    return details::catch_layer<sizeof...(Es), Es...>::template run<R>(fn);
+  }
+
+  /**
+   *  Returns the Ok value of @p r or throws its error: a caught_exception is
+   *  rethrown as the original exception, a std::exception is thrown as is and
+   *  anything else is wrapped in a result_error<E>.
+   */
+  template<typename T, typename E>
+  T into_exception(Result<T, E>&& r) {
+    if (r.is_err()) {
+      details::throw_error(std::move(r).err());
+    }
+    return std::move(r).ok();
+  }
+} // namespace util
+
+#endif /* end of include guard: EXCEPTIONS_HPP_Q4N8ZC1W */
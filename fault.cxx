@@ -0,0 +1,166 @@
+/*
+ * fault.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "fault.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace{
+  using util::fault::point;
+
+  constexpr unsigned point_count = static_cast<unsigned>(point::count);
+
+  const char* const names[point_count] = {"open", "as_string", "file_size", "map_file", "try"};
+
+  // One cache line each, Try_ asks from every thread.
+  struct alignas(64) point_state {
+    // Fails when the call's hash is below it. UINT64_MAX always fails.
+    std::atomic<std::uint64_t> threshold{0};
+    std::atomic<double> probability{0.0};
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> injected{0};
+  };
+
+  point_state points[point_count];
+  std::atomic<std::uint64_t> seed{0};
+
+  // splitmix64's finalizer.
+  std::uint64_t mix(std::uint64_t x) noexcept {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  struct faults_from_env {
+    faults_from_env() {
+      if(const char* spec = std::getenv("RESULT_FAULTS")){
+        util::fault::configure(spec);
+      }
+    }
+  } faults_from_env_;
+}
+
+namespace util {
+  namespace fault {
+    const char* name(point p) noexcept {
+      return static_cast<unsigned>(p) < point_count ? names[static_cast<unsigned>(p)] : "?";
+    }
+
+    void set(point p, double probability) noexcept {
+      if(static_cast<unsigned>(p) >= point_count){
+        return;
+      }
+      if(!(probability > 0.0)){
+        probability = 0.0;
+      } else if(probability > 1.0){
+        probability = 1.0;
+      }
+      point_state& s = points[static_cast<unsigned>(p)];
+      s.probability.store(probability, std::memory_order_relaxed);
+      s.threshold.store(probability >= 1.0 ? UINT64_MAX
+                                           : static_cast<std::uint64_t>(probability * 18446744073709551616.0),
+                        std::memory_order_relaxed);
+    }
+
+    bool set(const char* name, double probability) noexcept {
+      for(unsigned i = 0; i < point_count; ++i){
+        if(std::strcmp(name, names[i]) == 0){
+          set(static_cast<point>(i), probability);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    double probability(point p) noexcept {
+      if(static_cast<unsigned>(p) >= point_count){
+        return 0.0;
+      }
+      return points[static_cast<unsigned>(p)].probability.load(std::memory_order_relaxed);
+    }
+
+    void set_seed(std::uint64_t s) noexcept {
+      seed.store(s, std::memory_order_relaxed);
+      for(point_state& p : points){
+        p.calls.store(0, std::memory_order_relaxed);
+        p.injected.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    bool configure(const char* spec) noexcept {
+      while(*spec != '\0'){
+        const char* eq  = std::strchr(spec, '=');
+        const char* end = std::strchr(spec, ',');
+        if(end == nullptr){
+          end = spec + std::strlen(spec);
+        }
+        if(eq == nullptr || eq > end){
+          return false;
+        }
+        char key[16];
+        const std::size_t key_len = static_cast<std::size_t>(eq - spec);
+        if(key_len >= sizeof(key)){
+          return false;
+        }
+        std::memcpy(key, spec, key_len);
+        key[key_len] = '\0';
+
+        char* parsed = nullptr;
+        if(std::strcmp(key, "seed") == 0){
+          const unsigned long long s = std::strtoull(eq + 1, &parsed, 0);
+          if(parsed != end){
+            return false;
+          }
+          set_seed(s);
+        } else {
+          const double p = std::strtod(eq + 1, &parsed);
+          if(parsed != end || !set(key, p)){
+            return false;
+          }
+        }
+        spec = *end == ',' ? end + 1 : end;
+      }
+      return true;
+    }
+
+    void reset() noexcept {
+      for(unsigned i = 0; i < point_count; ++i){
+        set(static_cast<point>(i), 0.0);
+      }
+      set_seed(0);
+    }
+
+    point_stats stats(point p) noexcept {
+      if(static_cast<unsigned>(p) >= point_count){
+        return {0, 0};
+      }
+      const point_state& s = points[static_cast<unsigned>(p)];
+      return {s.calls.load(std::memory_order_relaxed),
+              s.injected.load(std::memory_order_relaxed)};
+    }
+
+    bool should_fail(point p) noexcept {
+      point_state& s = points[static_cast<unsigned>(p)];
+      const std::uint64_t threshold = s.threshold.load(std::memory_order_relaxed);
+      if(threshold == 0){
+        return false;
+      }
+      const std::uint64_t n = s.calls.fetch_add(1, std::memory_order_relaxed);
+      // Seed and point first, so that seeds aren't just shifted sequences.
+      const std::uint64_t stream =
+        mix(seed.load(std::memory_order_relaxed) ^ ((static_cast<std::uint64_t>(p) + 1) << 56));
+      if(threshold != UINT64_MAX && mix(stream ^ n) >= threshold){
+        return false;
+      }
+      s.injected.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  } // namespace fault
+} // namespace util
@@ -0,0 +1,75 @@
+/*
+ * fault.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef FAULT_HPP_R6JX3W9C
+#define FAULT_HPP_R6JX3W9C
+
+// Fault injection for measuring how the error paths behave when errors are
+// common. Built with RESULT_FAULTS=1, util::open(), util::as_string(),
+// file_size(), util::map_file() and every Try_ ask should_fail() for their
+// point first, and take the Err branch when it says so: utils with an EIO
+// io_error, Try_ with injected_error<E>() in place of an ok result.
+//
+// Each point fails with its own probability, 0 by default, set through
+// set() or RESULT_FAULTS in the environment:
+//
+//   RESULT_FAULTS="open=0.01,try=0.001,seed=42" ./build/bin/tests
+//
+// Decisions are a hash of the seed, the point and how many times the point
+// was asked before, so the same seed fails the same calls on every run.
+// Across threads the set of failing call numbers is still the same, but
+// which thread makes which call isn't.
+
+#include <cstdint>
+
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+RESULT_EXPORT namespace util {
+  namespace fault {
+    enum class point : unsigned {
+      open,      // util::open
+      as_string, // util::as_string, before reading
+      file_size, // file_size() under as_string
+      map_file,  // util::map_file
+      try_,      // every Try_ on an ok result
+      count
+    };
+
+    // The name used by set() and RESULT_FAULTS.
+    const char* name(point p) noexcept;
+
+    // Clamped to [0, 1].
+    void set(point p, double probability) noexcept;
+    // false if @p name isn't a point.
+    bool set(const char* name, double probability) noexcept;
+    double probability(point p) noexcept;
+
+    // Also restarts every point's call count, so the decisions that follow
+    // are the same as the first ones made with @p seed.
+    void set_seed(std::uint64_t seed) noexcept;
+
+    // Applies a RESULT_FAULTS style "name=probability,...,seed=n" list.
+    // false, after applying what came before it, on the first bad entry.
+    bool configure(const char* spec) noexcept;
+
+    // Probabilities back to 0, seed to 0 and counters cleared.
+    void reset() noexcept;
+
+    struct point_stats {
+      std::uint64_t calls;    // asked while the probability wasn't 0
+      std::uint64_t injected; // of which failed
+    };
+
+    point_stats stats(point p) noexcept;
+
+    bool should_fail(point p) noexcept;
+  } // namespace fault
+} // namespace util
+
+#endif /* end of include guard: FAULT_HPP_R6JX3W9C */
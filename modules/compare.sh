@@ -0,0 +1,63 @@
+#! /bin/sh
+#
+# compare.sh
+# Copyright (C) 2017 rsw0x
+#
+# Distributed under terms of the MPLv2 license.
+#
+# compare.sh <measure binary> <module mapper> <output dir> [count]
+#
+# Compiles <count> (default 20) small TUs using utils twice, once with
+# #include "utils.hpp" and once with import util.io, and prints the total
+# and per TU compile time of each. The util.io BMI must already be built.
+
+MEASURE=$1
+MAPPER=$2
+OUT=$3
+COUNT=${4:-20}
+CXX=${CXX:-c++}
+HERE=$(cd "$(dirname "$0")/.." && pwd)
+
+if [ -z "$MEASURE" ] || [ -z "$MAPPER" ] || [ -z "$OUT" ]; then
+  echo "usage: $0 <measure binary> <module mapper> <output dir> [count]" >&2
+  exit 2
+fi
+
+mkdir -p "$OUT"
+FLAGS="-std=c++20 -fmodules-ts -fmodule-mapper=$MAPPER -O0 -I$HERE"
+
+gen() {
+  # $1: include or import, $2: index
+  if [ "$1" = include ]; then
+    echo '#include "utils.hpp"'
+  else
+    echo '#include "result_macros.hpp"'
+    echo 'import util.io;'
+  fi
+  cat <<TU
+util::IOError<unsigned long> size_$2(const char* path) {
+  auto file = Try_(util::open(path, util::openmode::in).context("open $2"));
+  auto contents = Try_(util::as_string(file));
+  return contents.size();
+}
+TU
+}
+
+printf "mode\ttus\ttotal_seconds\tper_tu_seconds\n"
+for mode in include import; do
+  total=0
+  i=0
+  while [ $i -lt "$COUNT" ]; do
+    src="$OUT/${mode}_$i.cxx"
+    gen $mode $i > "$src"
+    if ! res=$("$MEASURE" "$CXX" $FLAGS -c "$src" -o "$OUT/${mode}_$i.o" 2>&1); then
+      echo "$mode: compiling $src failed" >&2
+      echo "$res" | tail -5 >&2
+      exit 1
+    fi
+    t=$(echo "$res" | tail -1 | cut -d' ' -f1)
+    total=$(echo "$total $t" | awk '{ print $1 + $2 }')
+    i=$((i + 1))
+  done
+  echo "$mode $COUNT $total" | awk '{ printf "%s\t%d\t%.3f\t%.3f\n", $1, $2, $3, $3 / $2 }'
+done
@@ -0,0 +1,55 @@
+/*
+ * import_test.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// Uses Result and utils through import only. Exits non-zero on failure.
+
+#include "../result_macros.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+import util.io;
+
+namespace {
+  int failures = 0;
+
+  void check(bool ok, const char* what) {
+    if (!ok) {
+      std::fprintf(stderr, "import_test: check failed: %s\n", what);
+      ++failures;
+    }
+  }
+
+  util::IOError<std::size_t> read_size(const char* path) {
+    auto file     = Try_(util::open(path, util::openmode::in));
+    auto contents = Try_(util::as_string(file));
+    return contents.size();
+  }
+} // namespace
+
+int main() {
+  util::Result<int, const char*> r = util::Ok(2);
+  check(r.apply([](int& i) { return i * 2; }).ok() == 4, "apply");
+
+  auto missing = read_size("/no/such/file").context("reading");
+  check(missing.is_err(), "open failure is an Err");
+  check(missing.err().errnum() == ENOENT, "errno is kept");
+  check(std::strstr(get_context(missing.err()), "reading") != nullptr,
+        "context is rendered");
+
+  auto made = util::try_make_string(4096);
+  check(made.is_ok() && made.ok().size() == 4096 && made.ok()[4095] == '\0',
+        "try_make_string");
+  auto size = read_size("modules/import_test.cxx");
+  check(size.is_ok() && size.ok() > 0, "as_string reads a file");
+
+  if (failures == 0) {
+    std::printf("import_test: OK\n");
+  }
+  return failures == 0 ? 0 : 1;
+}
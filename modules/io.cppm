@@ -0,0 +1,48 @@
+/*
+ * io.cppm
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// util.io: utils.hpp as a module, re-exporting util.result.
+//
+// Declarations attached to a named module are mangled as such, so the
+// non-inline definitions have to be compiled as part of the module too:
+// utils.cxx is included at the end instead of being linked separately.
+
+module;
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+export module util.io;
+
+export import util.result;
+
+#define RESULT_EXPORT export
+#include "../result_macros.hpp"
+// Result itself comes from util.result, don't declare it again here. This
+// still gets the io_error forward declarations from result_fwd.hpp.
+#define RESULT_HPP_7LRAEJZ5
+#define RESULT_FWD_HPP_X81DKQ2M
+#include "../utils.hpp"
+
+#include "../utils.cxx"
@@ -0,0 +1,23 @@
+/*
+ * result.cppm
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// util.result: result.hpp as a module. Importers that want Try_ also
+// include result_macros.hpp.
+
+module;
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+export module util.result;
+
+#define RESULT_EXPORT export
+// io_error and friends belong to util.io.
+#define RESULT_FWD_CORE_ONLY
+#include "../result.hpp"
@@ -0,0 +1,235 @@
+/*
+ * origin.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "origin.hpp"
+
+#include "contrib/backward.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace{
+  using util::origin::max_frames;
+  using util::origin::store_capacity;
+  using util::origin::trace;
+
+  std::atomic<unsigned> every{1};
+  thread_local unsigned countdown = 0;
+
+  // Insert-only, lock-free, like result_audit.cxx's table. Slot::state:
+  // 0 = empty, 1 = being written, 2 = published. A trace's id is its slot
+  // index + 1. A slot being written is probed past rather than waited for,
+  // as in utils.cxx's intern_table: two threads storing the same trace at
+  // once may get an id each.
+  struct slot {
+    std::atomic<std::uint32_t> state{0};
+    std::uint32_t hash;
+    trace frames;
+  };
+
+  static_assert((store_capacity & (store_capacity - 1)) == 0, "store_capacity must be a power of two.");
+  // Bounds the cost of interning into a nearly full store.
+  constexpr std::uint32_t max_probes = 64;
+
+  slot store[store_capacity];
+  std::atomic<std::uint64_t> unique{0};
+  std::atomic<std::uint64_t> dropped{0};
+
+  std::uint32_t hash_frames(const trace& t) {
+    std::uint64_t h = t.count;
+    for(unsigned i = 0; i < t.count; ++i){
+      h = (h ^ reinterpret_cast<std::uintptr_t>(t.frames[i])) * 0x9e3779b97f4a7c15ull;
+    }
+    return static_cast<std::uint32_t>(h >> 32);
+  }
+
+  bool same_frames(const slot& s, std::uint32_t hash, const trace& t) {
+    return s.hash == hash && s.frames.count == t.count &&
+           std::equal(t.frames, t.frames + t.count, s.frames.frames);
+  }
+
+  util::origin::id intern(const trace& t) {
+    const std::uint32_t hash = hash_frames(t);
+    for(std::uint32_t i = 0; i < max_probes; ++i){
+      const std::uint32_t index = (hash + i) & (store_capacity - 1);
+      slot& s = store[index];
+      std::uint32_t state = s.state.load(std::memory_order_acquire);
+      if(state == 0){
+        if(s.state.compare_exchange_strong(state, 1, std::memory_order_acquire)){
+          s.hash = hash;
+          s.frames = t;
+          s.state.store(2, std::memory_order_release);
+          unique.fetch_add(1, std::memory_order_relaxed);
+          return index + 1;
+        }
+      }
+      if(state == 2 && same_frames(s, hash, t)){
+        return index + 1;
+      }
+    }
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  // Frames above capture()'s caller, which is Result's constructor or
+  // inlined into the function making the Err.
+  constexpr unsigned skip_slack = 8;
+
+  struct collect {
+    void** frames;
+
+    void operator()(std::size_t idx, void* addr) noexcept {
+      frames[idx] = addr;
+    }
+  };
+
+  // backward::TraceResolver::load_stacktrace() wants something shaped like
+  // a StackTrace.
+  struct frames_view {
+    void** frames;
+    std::size_t count;
+
+    std::size_t size() const noexcept {
+      return count;
+    }
+
+    void** begin() noexcept {
+      return frames;
+    }
+  };
+
+  // print()'s resolver and what it made of each id, kept for the life of
+  // the process: the DWARF behind a trace doesn't change, and setting the
+  // resolver up is the expensive part.
+  struct printer {
+    std::mutex lock;
+    backward::TraceResolver resolver;
+    std::unordered_map<util::origin::id, std::string> printed;
+
+    const std::string& lines(util::origin::id origin, const trace& t) {
+      std::string& out = printed[origin];
+      if(!out.empty()){
+        return out;
+      }
+      void* frames[max_frames];
+      std::copy(t.frames, t.frames + t.count, frames);
+      frames_view view{frames, t.count};
+      resolver.load_stacktrace(view);
+      for(unsigned i = 0; i < t.count; ++i){
+        const backward::ResolvedTrace r =
+          resolver.resolve(backward::ResolvedTrace(backward::Trace(t.frames[i], i)));
+        const std::string& function =
+          r.source.function.empty() ? r.object_function : r.source.function;
+        char head[64];
+        std::snprintf(head, sizeof(head), "  #%u %p ", i, t.frames[i]);
+        out += head;
+        out += function.empty() ? "??" : function;
+        if(!r.source.filename.empty()){
+          out += " at " + r.source.filename + ":" + std::to_string(r.source.line);
+        } else if(!r.object_filename.empty()){
+          out += " in " + r.object_filename;
+        }
+        out += '\n';
+      }
+      return out;
+    }
+  };
+
+  struct sample_from_env {
+    sample_from_env() {
+      if(const char* n = std::getenv("RESULT_ORIGIN_SAMPLE")){
+        util::origin::set_sample_every(static_cast<unsigned>(std::strtoul(n, nullptr, 10)));
+      }
+    }
+  } sample_from_env_;
+}
+
+namespace util {
+  namespace origin {
+    void set_sample_every(unsigned n) noexcept {
+      every.store(n, std::memory_order_relaxed);
+      countdown = 0;
+    }
+
+    unsigned sample_every() noexcept {
+      return every.load(std::memory_order_relaxed);
+    }
+
+    __attribute__((noinline)) id capture() noexcept {
+      if(countdown > 1){
+        --countdown;
+        return 0;
+      }
+      countdown = every.load(std::memory_order_relaxed);
+      if(countdown == 0){
+        return 0;
+      }
+
+      // The unwinder reports call sites (return address - 1), so look for
+      // our caller's that way and drop everything above it.
+      char* const caller = static_cast<char*>(__builtin_return_address(0)) - 1;
+      void* frames[max_frames + skip_slack];
+#if BACKWARD_HAS_FP == 1
+      const std::size_t n = backward::details::unwind_frame_pointers(
+        collect{frames}, __builtin_frame_address(0), max_frames + skip_slack);
+#elif BACKWARD_HAS_UNWIND == 1
+      const std::size_t n = backward::details::unwind(collect{frames}, max_frames + skip_slack);
+#else
+      std::size_t n = static_cast<std::size_t>(::backtrace(frames, max_frames + skip_slack));
+      for(std::size_t i = 0; i < n; ++i){
+        frames[i] = static_cast<char*>(frames[i]) - 1;
+      }
+#endif
+      std::size_t first = 0;
+      while(first < n && frames[first] != caller){
+        ++first;
+      }
+      trace t = {};
+      if(first == n){
+        t.frames[0] = caller;
+        t.count = 1;
+      }
+      for(; first < n && t.count < max_frames; ++first){
+        t.frames[t.count++] = frames[first];
+      }
+      return intern(t);
+    }
+
+    bool lookup(id i, trace& t) noexcept {
+      if(i == 0 || i > store_capacity){
+        return false;
+      }
+      const slot& s = store[i - 1];
+      if(s.state.load(std::memory_order_acquire) != 2){
+        return false;
+      }
+      t = s.frames;
+      return true;
+    }
+
+    store_stats stats() noexcept {
+      return {unique.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed)};
+    }
+
+    void print(id origin, std::FILE* out) {
+      trace t;
+      if(!lookup(origin, t)){
+        return;
+      }
+      // Never destroyed: an Err can abort and print during static
+      // destruction.
+      static printer& p = *new printer;
+      std::lock_guard<std::mutex> guard(p.lock);
+      std::fputs(p.lines(origin, t).c_str(), out);
+    }
+  } // namespace origin
+} // namespace util
@@ -0,0 +1,72 @@
+/*
+ * origin.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef ORIGIN_HPP_B4ZQ8M1T
+#define ORIGIN_HPP_B4ZQ8M1T
+
+// Where an error was created. Built with RESULT_ORIGIN=1, a Result captures
+// the raw return addresses of the code constructing its Err, keeps them
+// through copies, moves, Try_ and apply(), and an aborting ok() prints them.
+// Only addresses are stored: they're symbolized through backward.hpp's
+// TraceResolver when printed.
+//
+// Traces are interned in a global store and a Result only carries the
+// trace's 32-bit id, so a burst of errors from the same few places costs a
+// lookup each rather than a copy of the frames. The store is a fixed table
+// of store_capacity traces that is never evicted from: once it's full, or a
+// trace's probe sequence is, new traces get id 0 and are only counted.
+//
+// Capturing walks the stack (through frame pointers when built with
+// BACKWARD_HAS_FP, see backward.hpp), so only every sample_every()th Err per
+// thread is captured; set_sample_every() or RESULT_ORIGIN_SAMPLE=<n> in the
+// environment bound the cost. Unsampled Errs just decrement a counter.
+
+#include <cstdint>
+#include <cstdio>
+
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+RESULT_EXPORT namespace util {
+  namespace origin {
+    constexpr unsigned max_frames = 4;
+
+    constexpr std::uint32_t store_capacity = 1u << 14;
+
+    struct trace {
+      void* frames[max_frames];
+      unsigned count;
+    };
+
+    // An interned trace. 0 is "no origin": not sampled, or not stored.
+    using id = std::uint32_t;
+
+    struct store_stats {
+      std::uint64_t unique;  // traces stored
+      std::uint64_t dropped; // traces that found no room
+    };
+
+    // 1 captures every Err, 0 none. Defaults to 1.
+    void set_sample_every(unsigned n) noexcept;
+    unsigned sample_every() noexcept;
+
+    // The id of the frames calling into Result if this Err is sampled,
+    // otherwise 0.
+    id capture() noexcept;
+
+    // Copies the frames @p i stands for into @p t. False for 0.
+    bool lookup(id i, trace& t) noexcept;
+
+    store_stats stats() noexcept;
+
+    // One "#i function at file:line" line per frame, nothing for 0.
+    void print(id i, std::FILE* out);
+  } // namespace origin
+} // namespace util
+
+#endif /* end of include guard: ORIGIN_HPP_B4ZQ8M1T */
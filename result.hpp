@@ -21,29 +21,174 @@
 #define UNLIKELY(x) static_cast<bool>(x)
 #endif
 
+#include "result_macros.hpp"
+
+// With concepts a REQUIRES() is a type-constraint on a defaulted hidden
+// parameter: satisfaction is checked (and cached) by the compiler instead of
+// instantiating an enable_if per overload.
 #pragma push_macro("REQUIRES")
 #undef REQUIRES
+#if RESULT_CONCEPTS
+#define REQUIRES(...)                                                          \
+  details::when_<static_cast<bool>(__VA_ARGS__)> hiddenType__ = void
+#else
+// hiddenBool__ makes conditions on class parameters dependent.
 #define REQUIRES(...)                                                          \
-  details::unique_t<__LINE__>::type = details::unique_t<__LINE__>::type::e,    \
-  bool hiddenBool__ = true, std::enable_if_t < hiddenBool__ && (__VA_ARGS__),  \
-  int >             = 0
+  bool hiddenBool__ = true,                                                    \
+       std::enable_if_t < hiddenBool__ && (__VA_ARGS__), int > = 0
+#endif
 
 #include <cstdio>
 #include <cstdlib>
-#include <functional>
 #include <new>
 #include <type_traits>
 #include <utility>
 
-namespace util {
-  template<typename T, typename E>
-  struct Result;
+#include "result_fwd.hpp"
+
+#if RESULT_STATS || RESULT_TRACE || RESULT_AUDIT
+#include "result_stats.hpp"
+#endif
+#if RESULT_TRACE
+#include "trace.hpp"
+#endif
+#if RESULT_AUDIT
+#include "result_audit.hpp"
+#endif
+#if RESULT_ORIGIN
+#include "origin.hpp"
+#endif
+#if RESULT_FAULTS
+#include "fault.hpp"
+#endif
+
+// With RESULT_STATS or RESULT_TRACE, Err(), the E converting constructor,
+// apply() and the accessors take the caller's location as a trailing
+// defaulted parameter and report what happened there to
+// details::record_site(). Otherwise these expand to nothing.
+//
+// RESULT_AUDIT also takes the caller's location in the constructors and
+// ok_or(), and threads it down to reconstruct() as the origin of the copy or
+// move it reports to util::audit.
+#pragma push_macro("RESULT_SITE_")
+#pragma push_macro("RESULT_SITE_ARG_")
+#pragma push_macro("RESULT_PROPAGATE_")
+#pragma push_macro("RESULT_RECORD_")
+#pragma push_macro("RESULT_AUDIT_SITE_")
+#pragma push_macro("RESULT_AUDIT_PARAM_")
+#pragma push_macro("RESULT_AUDIT_FWD_")
+#pragma push_macro("RESULT_AUDIT_")
+#pragma push_macro("RESULT_AUDIT_NOSITE_")
+#pragma push_macro("RESULT_PROPAGATE_ERR_")
+#pragma push_macro("RESULT_CAPTURE_ORIGIN_")
+#undef RESULT_SITE_
+#undef RESULT_SITE_ARG_
+#undef RESULT_PROPAGATE_
+#undef RESULT_RECORD_
+#undef RESULT_AUDIT_SITE_
+#undef RESULT_AUDIT_PARAM_
+#undef RESULT_AUDIT_FWD_
+#undef RESULT_AUDIT_
+#undef RESULT_AUDIT_NOSITE_
+#undef RESULT_PROPAGATE_ERR_
+#undef RESULT_CAPTURE_ORIGIN_
+#if RESULT_STATS || RESULT_TRACE || RESULT_AUDIT
+#define RESULT_SITE_                                                           \
+  , ::util::stats::site site__ = ::util::stats::site::current()
+#define RESULT_SITE_ARG_ , site__
+#define RESULT_PROPAGATE_ , site__.as(::util::stats::event::propagate)
+#else
+#define RESULT_SITE_
+#define RESULT_SITE_ARG_
+#define RESULT_PROPAGATE_
+#endif
+#if RESULT_STATS || RESULT_TRACE
+#define RESULT_RECORD_(site) ::util::details::record_site(site)
+#elif RESULT_AUDIT
+#define RESULT_RECORD_(site) static_cast<void>(site)
+#else
+#define RESULT_RECORD_(site) static_cast<void>(0)
+#endif
+#if RESULT_AUDIT
+#define RESULT_AUDIT_SITE_ RESULT_SITE_
+#define RESULT_AUDIT_PARAM_ , const ::util::audit::origin& origin__
+#define RESULT_AUDIT_FWD_ , origin__
+#define RESULT_AUDIT_(op) , ::util::audit::origin{op, site__.file, site__.line}
+#define RESULT_AUDIT_NOSITE_(op) , ::util::audit::origin{op, nullptr, 0}
+#else
+#define RESULT_AUDIT_SITE_
+#define RESULT_AUDIT_PARAM_
+#define RESULT_AUDIT_FWD_
+#define RESULT_AUDIT_(op)
+#define RESULT_AUDIT_NOSITE_(op)
+#endif
+
+// RESULT_ORIGIN: a new error captures where it was made, and apply() hands
+// its error on along with the origin it already has.
+#if RESULT_ORIGIN
+#define RESULT_PROPAGATE_ERR_(err, from)                                       \
+  ::util::details::propagate(err, (from).origin_ RESULT_PROPAGATE_)
+#define RESULT_CAPTURE_ORIGIN_() this->origin_ = ::util::origin::capture()
+#else
+#define RESULT_PROPAGATE_ERR_(err, from) err RESULT_PROPAGATE_
+#define RESULT_CAPTURE_ORIGIN_() static_cast<void>(0)
+#endif
+
+RESULT_EXPORT namespace util {
   namespace details {
 
-    template<int N>
-    struct unique_t {
-      enum class type { e };
-    };
+#if RESULT_STATS || RESULT_TRACE
+    inline void record_site(const stats::site& s) noexcept {
+#if RESULT_STATS
+      stats::record(s);
+#endif
+#if RESULT_TRACE
+      if (s.what == stats::event::err) {
+        trace::err_created(s.file, s.line);
+      }
+#endif
+    }
+#endif
+
+#if RESULT_AUDIT
+    // "... [with T = X; E = Y]", a name for Result<T, E> with static storage.
+    template<typename T, typename E>
+    const char* audit_type() noexcept {
+      return __PRETTY_FUNCTION__;
+    }
+
+    // Reference payloads are never copied, moved or destroyed, and trivially
+    // copyable ones are only memcpy'd, so neither is counted.
+    template<typename T, typename E, typename P>
+    void audit_payload(audit::payload p,
+                       audit::action a,
+                       const audit::origin& at) noexcept {
+      if (not std::is_reference<P>::value and
+          not std::is_trivially_copyable<P>::value) {
+        audit::record(audit_type<T, E>(), at, p, a);
+      }
+    }
+
+    // Constructing a payload P from a U&& copies or moves it when U is a P;
+    // anything else makes a new value and isn't counted.
+    template<typename T, typename E, typename P, typename U>
+    void audit_construct(audit::payload p, const audit::origin& at) noexcept {
+      if (std::is_same<std::decay_t<P>, std::decay_t<U>>::value) {
+        audit_payload<T, E, P>(
+          p,
+          std::is_lvalue_reference<U>::value or
+              std::is_const<std::remove_reference_t<U>>::value
+            ? audit::action::copy
+            : audit::action::move,
+          at);
+      }
+    }
+#endif
+
+#if RESULT_CONCEPTS
+    template<typename, bool B>
+    concept when_ = B;
+#endif
 
     template<typename T>
     struct is_result_impl : std::false_type {};
@@ -68,22 +213,37 @@ namespace util {
       using Err_T = typename result_flatten<E>::type;
     };
 
+    template<class...>
+    using void_t = void;
+
+    // std::result_of for plain calls, which is all apply()/ok_or() take.
+    // Cheaper than going through INVOKE, and result_of is gone in C++20.
+    template<typename Expr, typename Enabler = void>
+    struct result_of_impl {};
+
+    template<typename F, typename... Args>
+    struct result_of_impl<
+      F(Args...),
+      void_t<decltype(std::declval<F>()(std::declval<Args>()...))>> {
+      using type = decltype(std::declval<F>()(std::declval<Args>()...));
+    };
+
+    template<typename Expr>
+    using result_of_t = typename result_of_impl<Expr>::type;
+
     template<typename F>
     struct apply_traits {
-      using ret_t     = std::result_of_t<F>;
+      using ret_t     = result_of_t<F>;
       using flatten_t = typename result_flatten<ret_t>::Ok_T;
 
       static constexpr bool is_result = details::is_result<ret_t>;
     };
 
-    template<class...>
-    using void_t = void;
-
     template<typename Expr, typename Enabler = void>
     struct isCallableImpl : std::false_type {};
 
     template<typename F, typename... Args>
-    struct isCallableImpl<F(Args...), void_t<std::result_of_t<F(Args...)>>>
+    struct isCallableImpl<F(Args...), void_t<result_of_t<F(Args...)>>>
       : std::true_type {};
 
     template<typename Expr>
@@ -113,6 +273,30 @@ namespace util {
 
     struct EmptyWrapper {};
 
+#if RESULT_ORIGIN
+    // An error being passed on by Try_ or apply(), with the origin captured
+    // where it was first made.
+    template<typename E>
+    struct PropagatedErr {
+      E&& contents;
+      ::util::origin::id origin;
+#if RESULT_AUDIT
+      ::util::stats::site site;
+#endif
+    };
+
+    template<typename E>
+    PropagatedErr<E> propagate(E&& err,
+                               ::util::origin::id from RESULT_SITE_) {
+      RESULT_RECORD_(site__);
+#if RESULT_AUDIT
+      return {std::forward<E>(err), from, site__};
+#else
+      return {std::forward<E>(err), from};
+#endif
+    }
+#endif
+
 #ifdef __GNUC__
     [[noreturn]] inline void unreachable() {
       __builtin_unreachable();
@@ -149,25 +333,25 @@ namespace util {
       }
     };
 
-    // replace T& with std::reference_wrapper<T>
+    // replace T& with a pointer
     template<typename T>
     struct result_wrap_t<T&> {
     private:
-      std::reference_wrapper<T> contents;
+      T* contents;
 
     public:
       result_wrap_t(T& lval)
-        : contents(lval) {
+        : contents(__builtin_addressof(lval)) {
       }
 
       result_wrap_t(T&&) = delete;
 
       T& get() {
-        return contents.get();
+        return *contents;
       }
 
       const T& get() const {
-        return contents.get();
+        return *contents;
       }
     };
 
@@ -197,6 +381,9 @@ namespace util {
         }
       } contents;
       ValidityState validityState_ = ValidityState::invalid;
+#if RESULT_ORIGIN
+      ::util::origin::id origin_ = 0;
+#endif
 
       explicit BaseResult()
         : contents(dummy_t{})
@@ -218,25 +405,42 @@ namespace util {
       }
 
       void destruct() {
+#if RESULT_EXCEPTIONS
         try {
-          switch (validityState_) {
-            case ValidityState::ok:
-              // clang seems to not accept the decltype dtor syntax...
-              using val_dtor_t = decltype(contents.val);
-              contents.val.~val_dtor_t();
-              break;
-            case ValidityState::err:
-              using err_dtor_t = decltype(contents.err);
-              contents.err.~err_dtor_t();
-              break;
-            case ValidityState::invalid:
-              break;
-          }
-          validityState_ = ValidityState::invalid;
+          destruct_contents();
         } catch (...) {
           validityState_ = ValidityState::invalid;
           throw;
         }
+#else
+        destruct_contents();
+#endif
+      }
+
+    private:
+      void destruct_contents() {
+        switch (validityState_) {
+          case ValidityState::ok:
+#if RESULT_AUDIT
+            audit_payload<T, E, T>(
+              audit::payload::ok, audit::action::destroy, {"destroy", nullptr, 0});
+#endif
+            // clang seems to not accept the decltype dtor syntax...
+            using val_dtor_t = decltype(contents.val);
+            contents.val.~val_dtor_t();
+            break;
+          case ValidityState::err:
+#if RESULT_AUDIT
+            audit_payload<T, E, E>(
+              audit::payload::err, audit::action::destroy, {"destroy", nullptr, 0});
+#endif
+            using err_dtor_t = decltype(contents.err);
+            contents.err.~err_dtor_t();
+            break;
+          case ValidityState::invalid:
+            break;
+        }
+        validityState_ = ValidityState::invalid;
       }
     };
 
@@ -250,14 +454,23 @@ namespace util {
   }
 
   template<typename T>
-  details::ErrWrapper<T> Err(T&& val) {
+  details::ErrWrapper<T> Err(T&& val RESULT_SITE_) {
     static_assert(sizeof(details::ErrWrapper<T>) == sizeof(void*), "");
+    RESULT_RECORD_(site__);
     return {std::forward<T>(val)};
   }
 
+#if RESULT_STATS || RESULT_TRACE
+  inline details::EmptyWrapper Err(
+    ::util::stats::site site__ = ::util::stats::site::current()) {
+    RESULT_RECORD_(site__);
+    return {};
+  }
+#else
   constexpr details::EmptyWrapper Err() {
     return {};
   }
+#endif
 
   template<typename T, typename E>
   struct Result : private details::BaseResult<T, E> {
@@ -275,10 +488,11 @@ namespace util {
     using Base          = details::BaseResult<T, E>;
     using ValidityState = details::ValidityState;
 
-    using Error_T = std::remove_reference_t<decltype(
-      std::declval<typename Base::contents_t>().err.get())>;
-    using Ok_T    = std::remove_reference_t<decltype(
-      std::declval<typename Base::contents_t>().val.get())>;
+    // Spelled out rather than decltype'd from contents_t: GCC compares the
+    // decltype form structurally on every instantiation, which made class
+    // instantiation quadratic in the number of distinct Results.
+    using Error_T = std::remove_reference_t<E>;
+    using Ok_T    = std::remove_reference_t<T>;
 
     using Ok_Wrap_T    = decltype(Base::contents_t::val);
     using Error_Wrap_T = decltype(Base::contents_t::err);
@@ -300,26 +514,35 @@ namespace util {
     };
 
     template<typename U>
-    auto reconstruct(U&& val, details::ok_tag)
+    auto reconstruct(U&& val, details::ok_tag RESULT_AUDIT_PARAM_)
       -> decltype(construct_contract_t<U, T>{}, void()) {
+#if RESULT_AUDIT
+      details::audit_construct<T, E, T, U>(::util::audit::payload::ok, origin__);
+#endif
       this->validityState_ = ValidityState::ok;
       ::new (&(this->contents.val)) Ok_Wrap_T(std::forward<U>(val));
     }
 
     template<typename U>
-    auto reconstruct(U&& val, details::err_tag)
+    auto reconstruct(U&& val, details::err_tag RESULT_AUDIT_PARAM_)
       -> decltype(construct_contract_t<U, E>{}, void()) {
+#if RESULT_AUDIT
+      details::audit_construct<T, E, E, U>(::util::audit::payload::err, origin__);
+#endif
       this->validityState_ = ValidityState::err;
       ::new (&(this->contents.err)) Error_Wrap_T(std::forward<U>(val));
     }
 
-    void copy_assign(const Result& other) {
+    void copy_assign(const Result& other RESULT_AUDIT_PARAM_) {
+#if RESULT_ORIGIN
+      this->origin_ = other.origin_;
+#endif
       switch (other.validityState_) {
         case ValidityState::ok:
-          reconstruct(other.contents.ok(), details::ok_tag{});
+          reconstruct(other.contents.val.get(), details::ok_tag{} RESULT_AUDIT_FWD_);
           break;
         case ValidityState::err:
-          reconstruct(other.contents.err(), details::err_tag{});
+          reconstruct(other.contents.err.get(), details::err_tag{} RESULT_AUDIT_FWD_);
           break;
         case ValidityState::invalid:
           // TODO: this is always a bug, right?
@@ -329,14 +552,17 @@ namespace util {
       }
     }
 
-    void move_assign(Result&& other) {
+    void move_assign(Result&& other RESULT_AUDIT_PARAM_) {
+#if RESULT_ORIGIN
+      this->origin_ = other.origin_;
+#endif
       switch (other.validityState_) {
         case ValidityState::ok:
           // Forward because we may have reference params.
-          reconstruct(std::forward<T>(other.ok()), details::ok_tag{});
+          reconstruct(std::forward<T>(other.ok()), details::ok_tag{} RESULT_AUDIT_FWD_);
           break;
         case ValidityState::err:
-          reconstruct(std::forward<E>(other.err()), details::err_tag{});
+          reconstruct(std::forward<E>(other.err()), details::err_tag{} RESULT_AUDIT_FWD_);
           break;
         case ValidityState::invalid:
           // TODO: this is always a bug, right?
@@ -355,7 +581,7 @@ namespace util {
         return *this;
       }
       this->destruct();
-      copy_assign(other);
+      copy_assign(other RESULT_AUDIT_NOSITE_("operator="));
       return *this;
     }
 
@@ -364,56 +590,82 @@ namespace util {
         return *this;
       }
       this->destruct();
-      move_assign(std::move(other));
+      move_assign(std::move(other) RESULT_AUDIT_NOSITE_("operator="));
       return *this;
     }
 
     template<typename U>
     Result& operator=(const details::OkWrapper<U>& val) {
       this->destruct();
-      reconstruct(std::forward<U>(val.contents), details::ok_tag{});
+      reconstruct(std::forward<U>(val.contents),
+                  details::ok_tag{} RESULT_AUDIT_NOSITE_("operator="));
       return *this;
     }
 
     template<typename U>
     Result& operator=(const details::ErrWrapper<U>& val) {
       this->destruct();
-      reconstruct(std::forward<U>(val.contents), details::err_tag{});
+      RESULT_CAPTURE_ORIGIN_();
+      reconstruct(std::forward<U>(val.contents),
+                  details::err_tag{} RESULT_AUDIT_NOSITE_("operator="));
       return *this;
     }
 
-    Result(const Result& other) {
-      copy_assign(other);
+    Result(const Result& other RESULT_AUDIT_SITE_)
+      : Base() {
+      copy_assign(other RESULT_AUDIT_("copy"));
     }
 
-    Result(Result&& other) {
-      move_assign(std::move(other));
+    Result(Result&& other RESULT_AUDIT_SITE_) {
+      move_assign(std::move(other) RESULT_AUDIT_("move"));
     }
 
     ~Result() = default;
 
     template<typename U>
-    Result(details::OkWrapper<U>&& val) {
-      reconstruct(std::forward<U>(val.contents), details::ok_tag{});
+    Result(details::OkWrapper<U>&& val RESULT_AUDIT_SITE_) {
+      reconstruct(
+        std::forward<U>(val.contents), details::ok_tag{} RESULT_AUDIT_("Ok"));
     }
 
     template<typename U>
-    Result(details::ErrWrapper<U>&& val) {
-      reconstruct(std::forward<U>(val.contents), details::err_tag{});
+    Result(details::ErrWrapper<U>&& val RESULT_AUDIT_SITE_) {
+      RESULT_CAPTURE_ORIGIN_();
+      reconstruct(
+        std::forward<U>(val.contents), details::err_tag{} RESULT_AUDIT_("Err"));
     }
 
+#if RESULT_ORIGIN
+    template<typename U>
+    Result(details::PropagatedErr<U>&& val) {
+      this->origin_ = val.origin;
+#if RESULT_AUDIT
+      const ::util::stats::site& site__ = val.site;
+#endif
+      reconstruct(std::forward<U>(val.contents),
+                  details::err_tag{} RESULT_AUDIT_("propagate"));
+    }
+#endif
+
     constexpr Result(details::EmptyWrapper e)
       : Base(e) {
     }
 
     template<typename U, REQUIRES(std::is_constructible<Ok_T, U&&>{})>
-    Result(U&& val) {
-      reconstruct(std::forward<U>(val), details::ok_tag{});
+    Result(U&& val RESULT_AUDIT_SITE_) {
+      reconstruct(
+        std::forward<U>(val), details::ok_tag{} RESULT_AUDIT_("Result(T)"));
     }
 
     template<typename U, REQUIRES(std::is_constructible<Error_T, U&&>{})>
-    Result(U&& val) {
-      reconstruct(std::forward<U>(val), details::err_tag{});
+    Result(U&& val RESULT_SITE_) {
+      RESULT_RECORD_(site__);
+      RESULT_CAPTURE_ORIGIN_();
+      reconstruct(std::forward<U>(val),
+                  details::err_tag{} RESULT_AUDIT_(
+                    site__.what == ::util::stats::event::propagate
+                      ? "propagate"
+                      : "Result(E)"));
     }
 
     constexpr bool is_err() const noexcept {
@@ -432,54 +684,62 @@ namespace util {
       return is_ok();
     }
 
+#if RESULT_ORIGIN
+    // Where the error was made, 0 if it wasn't sampled. Only meaningful
+    // while is_err().
+    ::util::origin::id err_origin() const noexcept {
+      return this->origin_;
+    }
+#endif
+
     // TODO
-    const T& ok_unchecked(const char* msg = nullptr) const & {
-      return get_(msg);
+    const T& ok_unchecked(const char* msg = nullptr RESULT_SITE_) const & {
+      return get_(msg RESULT_SITE_ARG_);
     }
 
-    T& ok_unchecked(const char* msg = nullptr) & {
-      return get_(msg);
+    T& ok_unchecked(const char* msg = nullptr RESULT_SITE_) & {
+      return get_(msg RESULT_SITE_ARG_);
     }
 
-    T&& ok_unchecked(const char* msg = nullptr) && {
-      return std::move(get_(msg));
+    T&& ok_unchecked(const char* msg = nullptr RESULT_SITE_) && {
+      return std::forward<T>(get_(msg RESULT_SITE_ARG_));
     }
 
-    const T& ok(const char* msg = nullptr) const & {
-      return get_(msg);
+    const T& ok(const char* msg = nullptr RESULT_SITE_) const & {
+      return get_(msg RESULT_SITE_ARG_);
     }
 
-    T& ok(const char* msg = nullptr) & {
-      return get_(msg);
+    T& ok(const char* msg = nullptr RESULT_SITE_) & {
+      return get_(msg RESULT_SITE_ARG_);
     }
 
-    T&& ok(const char* msg = nullptr) && {
-      return std::move(get_(msg));
+    T&& ok(const char* msg = nullptr RESULT_SITE_) && {
+      return std::forward<T>(get_(msg RESULT_SITE_ARG_));
     }
 
-    const E& err(const char* msg = nullptr) const & {
-      return getErr_(msg);
+    const E& err(const char* msg = nullptr RESULT_SITE_) const & {
+      return getErr_(msg RESULT_SITE_ARG_);
     }
 
-    E& err(const char* msg = nullptr) & {
-      return getErr_(msg);
+    E& err(const char* msg = nullptr RESULT_SITE_) & {
+      return getErr_(msg RESULT_SITE_ARG_);
     }
 
-    E&& err(const char* msg = nullptr) && {
-      return std::move(getErr_(msg));
+    E&& err(const char* msg = nullptr RESULT_SITE_) && {
+      return std::forward<E>(getErr_(msg RESULT_SITE_ARG_));
     }
 
     // TODO
-    const E& err_unchecked(const char* msg = nullptr) const & {
-      return getErr_(msg);
+    const E& err_unchecked(const char* msg = nullptr RESULT_SITE_) const & {
+      return getErr_(msg RESULT_SITE_ARG_);
     }
 
-    E& err_unchecked(const char* msg = nullptr) & {
-      return getErr_(msg);
+    E& err_unchecked(const char* msg = nullptr RESULT_SITE_) & {
+      return getErr_(msg RESULT_SITE_ARG_);
     }
 
-    E&& err_unchecked(const char* msg = nullptr) && {
-      return std::move(getErr_(msg));
+    E&& err_unchecked(const char* msg = nullptr RESULT_SITE_) && {
+      return std::forward<E>(getErr_(msg RESULT_SITE_ARG_));
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -493,7 +753,7 @@ namespace util {
     template<typename F>
     using apply_ret_t =
       std::enable_if_t<details::isCallable<F> and
-                         not std::is_same<std::result_of_t<F>, void>::value,
+                         not std::is_same<details::result_of_t<F>, void>::value,
                        Result<typename apply_traits<F>::flatten_t, E>>;
 
   public:
@@ -506,39 +766,39 @@ namespace util {
      *
      */
     template<typename F, REQUIRES(details::isCallable<F(T&&)>)>
-    apply_ret_t<F(T&&)> apply(F&& fn) && {
+    apply_ret_t<F(T&&)> apply(F&& fn RESULT_SITE_) && {
       if (is_ok()) {
         return fn(std::move(ok()));
       } else {
-        return std::move(err());
+        return {RESULT_PROPAGATE_ERR_(std::move(err()), *this)};
       }
     }
 
     template<typename F, REQUIRES(not details::isCallable<F(T&&)>)>
-    apply_ret_t<F(T&)> apply(F&& fn) && {
+    apply_ret_t<F(T&)> apply(F&& fn RESULT_SITE_) && {
       if (is_ok()) {
         return fn(ok());
       } else {
-        return std::move(err());
+        return {RESULT_PROPAGATE_ERR_(std::move(err()), *this)};
       }
     }
 
     // TODO: wrapper for apply that returns the same Result<T,E> which only
     // conditionally moves if it is actually assigned.
     template<typename F>
-    apply_ret_t<F(T&)> apply(F&& fn) & {
+    apply_ret_t<F(T&)> apply(F&& fn RESULT_SITE_) & {
       // static_assert(not std::is_same<res_t, void>::value,
       //               "Cannot apply a function that returns void.");
       if (is_ok()) {
         return fn(ok());
       } else {
-        return err();
+        return {RESULT_PROPAGATE_ERR_(err(), *this)};
       }
     }
 
     template<typename F,
              REQUIRES(details::isCallable<F(T&)>and
-                        std::is_same<std::result_of_t<F(T&)>, void>())>
+                        std::is_same<details::result_of_t<F(T&)>, void>())>
     Result& apply(F&& fn) {
       if (is_ok()) {
         fn(ok());
@@ -552,12 +812,17 @@ namespace util {
   private:
   public:
     template<typename T2, REQUIRES(not details::isCallable<T2()>)>
-    T ok_or(T2&& orVal) && {
+    T ok_or(T2&& orVal RESULT_AUDIT_SITE_) && {
       static_assert(std::is_move_constructible<T>::value,
                     "T must be move constructible to use ok_or() with rvalue.");
       static_assert(std::is_convertible<T2&&, T>::value,
                     "Provided value cannot be converted to T.");
       if (is_ok()) {
+#if RESULT_AUDIT
+        details::audit_payload<T, E, T>(::util::audit::payload::ok,
+                                        ::util::audit::action::move,
+                                        {"ok_or", site__.file, site__.line});
+#endif
         return std::move(ok());
       } else {
         return std::forward<T2>(orVal);
@@ -568,12 +833,17 @@ namespace util {
      *  Overload for callable F allowing the alternative to be computed lazily.
      */
     template<typename F, REQUIRES(details::isCallable<F()>)>
-    T ok_or(F&& orFn) && {
-      static_assert(std::is_convertible<std::result_of_t<F()>, T>::value,
+    T ok_or(F&& orFn RESULT_AUDIT_SITE_) && {
+      static_assert(std::is_convertible<details::result_of_t<F()>, T>::value,
                     "Alternative does not return a type convertible to T.");
       static_assert(std::is_move_constructible<T>::value,
                     "T must be move constructible to use ok_or() with rvalue.");
       if (is_ok()) {
+#if RESULT_AUDIT
+        details::audit_payload<T, E, T>(::util::audit::payload::ok,
+                                        ::util::audit::action::move,
+                                        {"ok_or", site__.file, site__.line});
+#endif
         return std::move(ok());
       } else {
         return static_cast<T>(orFn());
@@ -581,12 +851,17 @@ namespace util {
     }
 
     template<typename T2, REQUIRES(not details::isCallable<T2()>)>
-    T ok_or(T2&& orVal) const & {
+    T ok_or(T2&& orVal RESULT_AUDIT_SITE_) const & {
       static_assert(std::is_copy_constructible<T>::value,
                     "lvalue okOr requires a copy constructible T.");
       static_assert(std::is_convertible<T2&&, T>::value,
                     "Provided value cannot be converted to T.");
       if (is_ok()) {
+#if RESULT_AUDIT
+        details::audit_payload<T, E, T>(::util::audit::payload::ok,
+                                        ::util::audit::action::copy,
+                                        {"ok_or", site__.file, site__.line});
+#endif
         return ok();
       } else {
         return static_cast<T>(std::forward<T2>(orVal));
@@ -597,12 +872,17 @@ namespace util {
      *  Overload for callable F allowing the alternative to be computed lazily.
      */
     template<typename F, REQUIRES(details::isCallable<F()>)>
-    T ok_or(F&& orFn) const & {
-      static_assert(std::is_convertible<std::result_of_t<F()>, T>::value,
+    T ok_or(F&& orFn RESULT_AUDIT_SITE_) const & {
+      static_assert(std::is_convertible<details::result_of_t<F()>, T>::value,
                     "Alternative does not return a type convertible to T.");
       static_assert(std::is_copy_constructible<T>::value,
                     "lvalue okOr requires a copy constructible T.");
       if (is_ok()) {
+#if RESULT_AUDIT
+        details::audit_payload<T, E, T>(::util::audit::payload::ok,
+                                        ::util::audit::action::copy,
+                                        {"ok_or", site__.file, site__.line});
+#endif
         return ok();
       } else {
         return static_cast<T>(orFn());
@@ -634,29 +914,29 @@ namespace util {
     // }
 
   private:
-    void err_if_(bool b, const char* msg) const {
+    void err_if_(bool b, const char* msg RESULT_SITE_) const {
       if (UNLIKELY(b)) {
-        abort_(msg);
+        abort_(msg RESULT_SITE_ARG_);
       }
     }
 
-    T& get_(const char* msg = nullptr) noexcept {
-      err_if_(!is_ok(), msg);
+    T& get_(const char* msg = nullptr RESULT_SITE_) noexcept {
+      err_if_(!is_ok(), msg RESULT_SITE_ARG_);
       return this->contents.val.get();
     }
 
-    const T& get_(const char* msg = nullptr) const noexcept {
-      err_if_(!is_ok(), msg);
+    const T& get_(const char* msg = nullptr RESULT_SITE_) const noexcept {
+      err_if_(!is_ok(), msg RESULT_SITE_ARG_);
       return this->contents.val.get();
     }
 
-    E& getErr_(const char* msg = nullptr) {
-      err_if_(!is_err(), msg);
+    E& getErr_(const char* msg = nullptr RESULT_SITE_) {
+      err_if_(!is_err(), msg RESULT_SITE_ARG_);
       return this->contents.err.get();
     }
 
-    const E& getErr_(const char* msg = nullptr) const noexcept {
-      err_if_(!is_err(), msg);
+    const E& getErr_(const char* msg = nullptr RESULT_SITE_) const noexcept {
+      err_if_(!is_err(), msg RESULT_SITE_ARG_);
       return this->contents.err.get();
     }
 
@@ -687,12 +967,19 @@ namespace util {
       std::fprintf(stderr, "Context: %s\n", get_context(err()));
     }
 
-    void abort_(const char* msg) const {
+    void abort_(const char* msg RESULT_SITE_) const {
+      RESULT_RECORD_(site__.as(::util::stats::event::abort));
       std::fprintf(stderr,
                    "Invalid Result access, message given: %s\n",
                    msg ? msg : "No message given.");
       if (is_err()) {
         print_ctx();
+#if RESULT_ORIGIN
+        if (this->origin_ != 0) {
+          std::fprintf(stderr, "Error created at:\n");
+          ::util::origin::print(this->origin_, stderr);
+        }
+#endif
       }
       std::abort();
       details::unreachable();
@@ -709,25 +996,42 @@ namespace util {
     return Err();
   }
 
-// rvalue ref keeps a temporary alive the same as a const ref [dcl.init.ref]
-//
-// TODO: unlikely TODO: currently attempts to return a default error if it's
-// invalid.
-//
-#define Try_(expr)                                                             \
-  ({                                                                           \
-    auto result_var_ = (expr);                                                 \
-    if (result_var_.is_err()) {                                                \
-      return util::Err(std::move(result_var_.err()));                          \
-    } else if (result_var_.is_invalid()) {                                     \
-      std::abort();                                                            \
-      return util::Err();                                                      \
-    }                                                                          \
-    std::move(result_var_.ok());                                               \
-  })
+#if RESULT_FAULTS
+  namespace details {
+    // What an injected fault in Try_ fails with: E::from_context() when E
+    // has one (io_error), otherwise E{} like Try_'s invalid branch.
+    template<typename E>
+    auto injected_error(int) -> decltype(E::from_context("Injected fault.")) {
+      return E::from_context("Injected fault.");
+    }
+
+    template<typename E>
+    E injected_error(long) {
+      return E{};
+    }
+
+    template<typename T, typename E>
+    void inject_fault(Result<T, E>& res) {
+      if (res.is_ok() && fault::should_fail(fault::point::try_)) {
+        res = Err(injected_error<E>(0));
+      }
+    }
+  } // namespace details
+#endif
 } // namespace util
 
 #pragma pop_macro("LIKELY")
 #pragma pop_macro("UNLIKELY")
 #pragma pop_macro("REQUIRES")
+#pragma pop_macro("RESULT_SITE_")
+#pragma pop_macro("RESULT_SITE_ARG_")
+#pragma pop_macro("RESULT_PROPAGATE_")
+#pragma pop_macro("RESULT_RECORD_")
+#pragma pop_macro("RESULT_AUDIT_SITE_")
+#pragma pop_macro("RESULT_AUDIT_PARAM_")
+#pragma pop_macro("RESULT_AUDIT_FWD_")
+#pragma pop_macro("RESULT_AUDIT_")
+#pragma pop_macro("RESULT_AUDIT_NOSITE_")
+#pragma pop_macro("RESULT_PROPAGATE_ERR_")
+#pragma pop_macro("RESULT_CAPTURE_ORIGIN_")
 #endif /* end of include guard: RESULT_HPP_7LRAEJZ5 */
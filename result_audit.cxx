@@ -0,0 +1,147 @@
+/*
+ * result_audit.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "result_audit.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace{
+  using util::audit::action;
+  using util::audit::origin;
+  using util::audit::payload;
+
+  // Insert-only, lock-free. Slot::state: 0 = empty, 1 = being written,
+  // 2 = published. Auditing is a debugging mode, so counters are shared by
+  // all threads rather than kept per thread.
+  struct slot {
+    std::atomic<std::uint32_t> state{0};
+    const char* type;
+    origin at;
+    std::atomic<std::uint64_t> counts[2][3];
+  };
+
+  constexpr std::size_t table_slots = 4096;
+  static_assert((table_slots & (table_slots - 1)) == 0, "table_slots must be a power of two.");
+
+  slot table[table_slots];
+  std::atomic<std::uint64_t> dropped{0};
+
+  bool same_key(const slot& s, const char* type, const origin& at) {
+    return s.type == type && s.at.op == at.op && s.at.file == at.file && s.at.line == at.line;
+  }
+
+  slot* find_or_insert(const char* type, const origin& at) {
+    const std::size_t hash = (reinterpret_cast<std::uintptr_t>(type) >> 3) * 31 +
+                             (reinterpret_cast<std::uintptr_t>(at.file) >> 3) * 17 +
+                             (reinterpret_cast<std::uintptr_t>(at.op) >> 3) + at.line;
+    for(std::size_t i = 0; i < table_slots; ++i){
+      slot& s = table[(hash + i) & (table_slots - 1)];
+      std::uint32_t state = s.state.load(std::memory_order_acquire);
+      if(state == 0){
+        if(s.state.compare_exchange_strong(state, 1, std::memory_order_acquire)){
+          s.type = type;
+          s.at = at;
+          s.state.store(2, std::memory_order_release);
+          return &s;
+        }
+      }
+      while(state == 1){
+        state = s.state.load(std::memory_order_acquire);
+      }
+      if(same_key(s, type, at)){
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+
+  // "... [with T = X; E = Y]" -> "Result<X, Y>"
+  std::string pretty_type(const char* type) {
+    const char* t = std::strstr(type, "[with T = ");
+    const char* e = t ? std::strstr(t, "; E = ") : nullptr;
+    const char* end = e ? std::strrchr(e, ']') : nullptr;
+    if(end == nullptr){
+      return type;
+    }
+    t += std::strlen("[with T = ");
+    return "Result<" + std::string(t, e) + ", " + std::string(e + 6, end) + ">";
+  }
+}
+
+namespace util {
+  namespace audit {
+    void record(const char* type, const origin& at, payload p, action a) noexcept {
+      slot* s = find_or_insert(type, at);
+      if(s == nullptr){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      s->counts[static_cast<int>(p)][static_cast<int>(a)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<entry> snapshot() {
+      std::vector<entry> entries;
+      for(const slot& s : table){
+        if(s.state.load(std::memory_order_acquire) != 2){
+          continue;
+        }
+        entry e{s.type, s.at, {}};
+        for(int p = 0; p < 2; ++p){
+          for(int a = 0; a < 3; ++a){
+            e.counts[p][a] = s.counts[p][a].load(std::memory_order_relaxed);
+          }
+        }
+        entries.push_back(e);
+      }
+      return entries;
+    }
+
+    std::uint64_t total(payload p, action a, const char* type_filter) {
+      std::uint64_t n = 0;
+      for(const entry& e : snapshot()){
+        if(type_filter == nullptr || std::strstr(e.type, type_filter) != nullptr){
+          n += e.count(p, a);
+        }
+      }
+      return n;
+    }
+
+    void reset() noexcept {
+      for(slot& s : table){
+        for(auto& per_payload : s.counts){
+          for(auto& count : per_payload){
+            count.store(0, std::memory_order_relaxed);
+          }
+        }
+      }
+      dropped.store(0, std::memory_order_relaxed);
+    }
+
+    void dump(std::FILE* out) {
+      std::fprintf(out, "type\top\tsite\tok_copies\tok_moves\tok_destroys\terr_copies\terr_moves\terr_destroys\n");
+      for(const entry& e : snapshot()){
+        std::fprintf(out, "%s\t%s\t", pretty_type(e.type).c_str(), e.at.op);
+        if(e.at.file != nullptr){
+          std::fprintf(out, "%s:%u", e.at.file, e.at.line);
+        } else {
+          std::fputc('-', out);
+        }
+        for(int p = 0; p < 2; ++p){
+          for(int a = 0; a < 3; ++a){
+            std::fprintf(out, "\t%llu", static_cast<unsigned long long>(e.counts[p][a]));
+          }
+        }
+        std::fputc('\n', out);
+      }
+      if(const std::uint64_t n = dropped.load(std::memory_order_relaxed)){
+        std::fprintf(out, "dropped\t%llu\n", static_cast<unsigned long long>(n));
+      }
+    }
+  } // namespace audit
+} // namespace util
@@ -0,0 +1,65 @@
+/*
+ * result_audit.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef RESULT_AUDIT_HPP_M2KC7WQE
+#define RESULT_AUDIT_HPP_M2KC7WQE
+
+// Copy/move auditing of Result payloads. Built with RESULT_AUDIT=1,
+// result.hpp reports every copy, move and destruction of a T or E it
+// performs, keyed by Result type, the operation doing it ("copy", "Ok",
+// "operator=", "ok_or", ...) and the caller's file and line where known.
+// Constructing a payload from a different type isn't counted, nor are
+// references and trivially copyable payloads.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+RESULT_EXPORT namespace util {
+  namespace audit {
+    enum class payload : std::uint8_t { ok, err };
+    enum class action : std::uint8_t { copy, move, destroy };
+
+    struct origin {
+      const char* op;
+      const char* file; // null where the caller isn't known
+      unsigned line;
+    };
+
+    // @p type must have static storage duration.
+    void record(const char* type, const origin& at, payload p, action a) noexcept;
+
+    struct entry {
+      const char* type;
+      origin at;
+      std::uint64_t counts[2][3]; // [payload][action]
+
+      std::uint64_t count(payload p, action a) const noexcept {
+        return counts[static_cast<int>(p)][static_cast<int>(a)];
+      }
+    };
+
+    std::vector<entry> snapshot();
+
+    // Sum of @p a on @p p over every entry whose type contains @p type_filter
+    // (every entry if null).
+    std::uint64_t total(payload p, action a, const char* type_filter = nullptr);
+
+    // Zeroes every counter. Not synchronized with concurrent recording.
+    void reset() noexcept;
+
+    // One line per entry: type, op, site, then ok/err copies, moves and
+    // destructions.
+    void dump(std::FILE* out);
+  } // namespace audit
+} // namespace util
+
+#endif /* end of include guard: RESULT_AUDIT_HPP_M2KC7WQE */
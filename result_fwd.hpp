@@ -0,0 +1,51 @@
+/*
+ * result_fwd.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef RESULT_FWD_HPP_X81DKQ2M
+#define RESULT_FWD_HPP_X81DKQ2M
+
+// Declarations only, no includes: enough to declare functions taking or
+// returning a Result. Include result.hpp (or utils.hpp) where they are
+// defined or called.
+
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+RESULT_EXPORT namespace util {
+  template<typename T, typename E>
+  struct Result;
+
+  namespace details {
+    template<typename T>
+    struct OkWrapper;
+
+    template<typename E>
+    struct ErrWrapper;
+
+    struct EmptyWrapper;
+  } // namespace details
+} // namespace util
+
+#endif /* end of include guard: RESULT_FWD_HPP_X81DKQ2M */
+
+// Types defined outside result.hpp get their own guard: the util.result
+// module leaves them out (RESULT_FWD_CORE_ONLY) and util.io declares them
+// itself, see modules/.
+#if !defined(RESULT_FWD_EXTRA_HPP_X81DKQ2M) && !defined(RESULT_FWD_CORE_ONLY)
+#define RESULT_FWD_EXTRA_HPP_X81DKQ2M
+
+RESULT_EXPORT namespace util {
+  struct io_error;
+
+  template<typename T>
+  using IOError = util::Result<T, io_error>;
+
+  struct caught_exception;
+} // namespace util
+
+#endif /* end of include guard: RESULT_FWD_EXTRA_HPP_X81DKQ2M */
@@ -0,0 +1,110 @@
+/*
+ * result_macros.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef RESULT_MACROS_HPP_5TB2QK8R
+#define RESULT_MACROS_HPP_5TB2QK8R
+
+// Configuration macros and Try_. Included by result.hpp; code that imports
+// the util.result module instead includes this, since macros can't be
+// exported from a module.
+
+#include <cstdlib>
+// Instantiations of Result in an importing TU need placement new, which
+// GCC doesn't make reachable through the module.
+#include <new>
+// Try_ expands to std::move.
+#include <utility>
+
+// Result (and utils) build both with and without exception support.
+#ifndef RESULT_EXCEPTIONS
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define RESULT_EXCEPTIONS 1
+#else
+#define RESULT_EXCEPTIONS 0
+#endif
+#endif
+
+#ifndef RESULT_CONCEPTS
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#define RESULT_CONCEPTS 1
+#else
+#define RESULT_CONCEPTS 0
+#endif
+#endif
+
+// Per call site error counters, see result_stats.hpp. Off by default.
+#ifndef RESULT_STATS
+#define RESULT_STATS 0
+#endif
+
+// Chrome trace of Result spans and Errs, see trace.hpp. Off by default.
+#ifndef RESULT_TRACE
+#define RESULT_TRACE 0
+#endif
+
+// Copy/move counters for Result payloads, see result_audit.hpp. Off by
+// default.
+#ifndef RESULT_AUDIT
+#define RESULT_AUDIT 0
+#endif
+
+// Where each Err was created, printed when ok() aborts, see origin.hpp. Off
+// by default.
+#ifndef RESULT_ORIGIN
+#define RESULT_ORIGIN 0
+#endif
+
+// Injected errors in utils and Try_, see fault.hpp. Off by default.
+#ifndef RESULT_FAULTS
+#define RESULT_FAULTS 0
+#endif
+
+// Expands to 'export' when the headers are included from a module interface
+// unit (see modules/).
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+#if RESULT_STATS || RESULT_TRACE || RESULT_AUDIT
+#define RESULT_TRY_SITE_                                                       \
+  , ::util::stats::site{__FILE__, __LINE__, ::util::stats::event::propagate}
+#else
+#define RESULT_TRY_SITE_
+#endif
+
+// With RESULT_ORIGIN the error keeps the origin it was captured at instead of
+// capturing Try_'s.
+#if RESULT_ORIGIN
+#define RESULT_TRY_ERR_(res)                                                   \
+  ::util::details::propagate(                                                  \
+    std::move(res.err()), res.err_origin() RESULT_TRY_SITE_)
+#else
+#define RESULT_TRY_ERR_(res) util::Err(std::move(res.err()) RESULT_TRY_SITE_)
+#endif
+
+#if RESULT_FAULTS
+#define RESULT_TRY_FAULT_(res) ::util::details::inject_fault(res)
+#else
+#define RESULT_TRY_FAULT_(res) static_cast<void>(0)
+#endif
+
+// rvalue ref keeps a temporary alive the same as a const ref [dcl.init.ref]
+//
+// An invalid result isn't an err, so it reaches ok(), which reports it and
+// aborts out of line like any other invalid access.
+//
+#define Try_(expr)                                                             \
+  ({                                                                           \
+    auto result_var_ = (expr);                                                 \
+    RESULT_TRY_FAULT_(result_var_);                                            \
+    if (result_var_.is_err()) {                                                \
+      return RESULT_TRY_ERR_(result_var_);                                     \
+    }                                                                          \
+    std::move(result_var_).ok();                                               \
+  })
+
+#endif /* end of include guard: RESULT_MACROS_HPP_5TB2QK8R */
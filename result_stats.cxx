@@ -0,0 +1,288 @@
+/*
+ * result_stats.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "result_stats.hpp"
+#include "thread_slot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace{
+  using util::stats::event;
+  using util::stats::site;
+
+  // One per thread, written only by the thread that owns it. A slot is
+  // published by the release store of its file, after line and event; its
+  // count only ever grows.
+  struct slot {
+    std::atomic<const char*> file{nullptr};
+    std::atomic<unsigned> line{0};
+    std::atomic<event> what{event::err};
+    std::atomic<std::uint64_t> count{0};
+  };
+
+  constexpr std::size_t table_slots = 1024;
+  static_assert((table_slots & (table_slots - 1)) == 0, "table_slots must be a power of two.");
+
+  // One per thread, see thread_slot.
+  struct table {
+    slot slots[table_slots];
+    std::atomic<std::uint64_t> dropped{0};
+  };
+
+  using tables = util::details::thread_slot<table>;
+
+  std::size_t hash_site(const site& s) {
+    return (reinterpret_cast<std::uintptr_t>(s.file) >> 3) * 31 + s.line * 4 +
+           static_cast<std::size_t>(s.what);
+  }
+
+  bool same_site(const slot& a, const char* file, unsigned line, event what) {
+    return a.line.load(std::memory_order_relaxed) == line &&
+           a.what.load(std::memory_order_relaxed) == what &&
+           std::strcmp(a.file.load(std::memory_order_relaxed), file) == 0;
+  }
+
+  template<typename F>
+  void for_each_slot(F&& fn) {
+    bool more = true;
+    tables::for_each([&](const table& t) {
+      for(std::size_t i = 0; more && i < table_slots; ++i){
+        const slot& s = t.slots[i];
+        const char* file = s.file.load(std::memory_order_acquire);
+        if(file != nullptr){
+          more = fn(s, file);
+        }
+      }
+    });
+  }
+
+  // Only async-signal-safe calls from here on.
+
+  struct fd_writer {
+    int fd;
+    char buf[512];
+    std::size_t used = 0;
+    bool ok = true;
+
+    void flush() {
+      std::size_t off = 0;
+      while(ok && off < used){
+        const ssize_t n = ::write(fd, buf + off, used - off);
+        if(n < 0 && errno == EINTR){
+          continue;
+        }
+        ok = n > 0;
+        off += ok ? static_cast<std::size_t>(n) : 0;
+      }
+      used = 0;
+    }
+
+    void put(const char* s) {
+      for(; *s; ++s){
+        if(used == sizeof(buf)){
+          flush();
+        }
+        buf[used++] = *s;
+      }
+    }
+
+    void put(std::uint64_t n) {
+      char digits[24];
+      char* p = digits + sizeof(digits);
+      *--p = '\0';
+      do{
+        *--p = static_cast<char>('0' + n % 10);
+        n /= 10;
+      } while(n != 0);
+      put(p);
+    }
+  };
+
+  struct dump_target {
+    char path[4096];
+    bool to_stderr;
+  };
+
+  dump_target signal_targets[NSIG];
+
+  void dump_on_signal_handler(int sig) {
+    const int saved_errno = errno;
+    if(sig > 0 && sig < NSIG){
+      if(signal_targets[sig].to_stderr){
+        util::stats::dump_fd(STDERR_FILENO);
+      } else {
+        util::stats::dump_to(signal_targets[sig].path);
+      }
+    }
+    errno = saved_errno;
+  }
+}
+
+namespace util {
+  namespace stats {
+    const char* to_string(event e) noexcept {
+      switch(e){
+        case event::err:
+          return "err";
+        case event::propagate:
+          return "propagate";
+        case event::abort:
+          return "abort";
+      }
+      return "?";
+    }
+
+    void record(const site& s) noexcept {
+      table* t = tables::get();
+      if(t == nullptr){
+        return;
+      }
+      const std::size_t hash = hash_site(s);
+      for(std::size_t i = 0; i < table_slots; ++i){
+        slot& sl = t->slots[(hash + i) & (table_slots - 1)];
+        const char* file = sl.file.load(std::memory_order_relaxed);
+        if(file == nullptr){
+          sl.line.store(s.line, std::memory_order_relaxed);
+          sl.what.store(s.what, std::memory_order_relaxed);
+          sl.count.store(1, std::memory_order_relaxed);
+          sl.file.store(s.file, std::memory_order_release);
+          return;
+        }
+        if(file == s.file && sl.line.load(std::memory_order_relaxed) == s.line &&
+           sl.what.load(std::memory_order_relaxed) == s.what){
+          // Single writer: no need for a locked add.
+          sl.count.store(sl.count.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+          return;
+        }
+      }
+      t->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<site_count> snapshot() {
+      std::vector<site_count> counts;
+      for_each_slot([&](const slot& s, const char* file) {
+        const unsigned line = s.line.load(std::memory_order_relaxed);
+        const event what = s.what.load(std::memory_order_relaxed);
+        const std::uint64_t n = s.count.load(std::memory_order_relaxed);
+        // The same file can show up under different pointers, e.g. from
+        // inline functions in different TUs.
+        auto it = std::find_if(counts.begin(), counts.end(), [&](const site_count& c) {
+          return c.line == line && c.what == what && std::strcmp(c.file, file) == 0;
+        });
+        if(it == counts.end()){
+          counts.push_back({file, line, what, n});
+        } else {
+          it->count += n;
+        }
+        return true;
+      });
+      std::sort(counts.begin(), counts.end(), [](const site_count& a, const site_count& b) {
+        return a.count > b.count;
+      });
+      return counts;
+    }
+
+    std::uint64_t dropped() noexcept {
+      std::uint64_t n = 0;
+      tables::for_each([&](const table& t) { n += t.dropped.load(std::memory_order_relaxed); });
+      return n;
+    }
+
+    void dump(std::FILE* out) {
+      for(const site_count& c : snapshot()){
+        std::fprintf(out, "%llu\t%s\t%s:%u\n", static_cast<unsigned long long>(c.count),
+                     to_string(c.what), c.file, c.line);
+      }
+      if(const std::uint64_t n = dropped()){
+        std::fprintf(out, "%llu\tdropped\n", static_cast<unsigned long long>(n));
+      }
+    }
+
+    bool dump_fd(int fd) noexcept {
+      fd_writer out{fd, {}};
+      // Merges without allocating: each site is printed at its first slot,
+      // summed over every slot with the same key.
+      for_each_slot([&](const slot& first, const char* file) {
+        const unsigned line = first.line.load(std::memory_order_relaxed);
+        const event what = first.what.load(std::memory_order_relaxed);
+        bool before = true;
+        bool seen = false;
+        std::uint64_t n = 0;
+        for_each_slot([&](const slot& s, const char*) {
+          if(&s == &first){
+            before = false;
+          }
+          if(!same_site(s, file, line, what)){
+            return true;
+          }
+          if(before){
+            // Already printed at an earlier slot.
+            seen = true;
+            return false;
+          }
+          n += s.count.load(std::memory_order_relaxed);
+          return true;
+        });
+        if(!seen){
+          out.put(n);
+          out.put("\t");
+          out.put(to_string(what));
+          out.put("\t");
+          out.put(file);
+          out.put(":");
+          out.put(static_cast<std::uint64_t>(line));
+          out.put("\n");
+        }
+        return out.ok;
+      });
+      if(const std::uint64_t n = dropped()){
+        out.put(n);
+        out.put("\tdropped\n");
+      }
+      out.flush();
+      return out.ok;
+    }
+
+    bool dump_to(const char* path) noexcept {
+      const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if(fd == -1){
+        return false;
+      }
+      const bool ok = dump_fd(fd);
+      return ::close(fd) == 0 && ok;
+    }
+
+    bool dump_on_signal(int sig, const char* path) noexcept {
+      if(sig <= 0 || sig >= NSIG){
+        return false;
+      }
+      dump_target& target = signal_targets[sig];
+      target.to_stderr = path == nullptr;
+      if(path != nullptr){
+        if(std::strlen(path) >= sizeof(target.path)){
+          return false;
+        }
+        std::strcpy(target.path, path);
+      }
+
+      struct sigaction sa;
+      std::memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = dump_on_signal_handler;
+      sa.sa_flags = SA_RESTART;
+      sigemptyset(&sa.sa_mask);
+      return sigaction(sig, &sa, nullptr) == 0;
+    }
+  } // namespace stats
+} // namespace util
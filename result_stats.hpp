@@ -0,0 +1,82 @@
+/*
+ * result_stats.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef RESULT_STATS_HPP_Q3VH8ZTD
+#define RESULT_STATS_HPP_Q3VH8ZTD
+
+// Per call site error counters. Built with RESULT_STATS=1, result.hpp
+// records every Err construction, Try_ propagation and invalid access here;
+// otherwise nothing calls into it.
+//
+// Each thread counts into its own table, so recording is a couple of
+// relaxed atomic stores with no contention. Tables are merged when read.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifndef RESULT_EXPORT
+#define RESULT_EXPORT
+#endif
+
+RESULT_EXPORT namespace util {
+  namespace stats {
+    enum class event : std::uint8_t {
+      err,       // an Err constructed, or an E converted to a Result
+      propagate, // an Err passed up by Try_ or apply()
+      abort,     // ok()/err() on the wrong alternative
+    };
+
+    const char* to_string(event e) noexcept;
+
+    struct site {
+      const char* file;
+      unsigned line;
+      event what = event::err;
+
+      // As a default argument, the location of the caller.
+      static constexpr site current(const char* file = __builtin_FILE(),
+                                    unsigned line = __builtin_LINE()) noexcept {
+        return {file, line};
+      }
+
+      constexpr site as(event e) const noexcept {
+        return {file, line, e};
+      }
+    };
+
+    void record(const site& s) noexcept;
+
+    struct site_count {
+      const char* file;
+      unsigned line;
+      event what;
+      std::uint64_t count;
+    };
+
+    // Counts summed over all threads, highest first.
+    std::vector<site_count> snapshot();
+
+    // Events not counted because a thread's table was full.
+    std::uint64_t dropped() noexcept;
+
+    // One "count\tevent\tfile:line" line per site.
+    void dump(std::FILE* out);
+
+    // Same format, unsorted, and async-signal-safe: no locks or allocation.
+    bool dump_fd(int fd) noexcept;
+
+    // Truncates @p path and dumps to it. Async-signal-safe.
+    bool dump_to(const char* path) noexcept;
+
+    // Dumps to @p path, or stderr if null, whenever @p sig is delivered.
+    // With SIGABRT this also covers invalid accesses, which abort.
+    bool dump_on_signal(int sig, const char* path = nullptr) noexcept;
+  } // namespace stats
+} // namespace util
+
+#endif /* end of include guard: RESULT_STATS_HPP_Q3VH8ZTD */
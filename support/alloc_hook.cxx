@@ -0,0 +1,183 @@
+/*
+ * alloc_hook.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "alloc_hook.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace{
+  // Trivially initialized, so touching it from operator new never runs a
+  // TLS constructor (which could itself allocate).
+  thread_local alloc_hook::counts this_thread = {0, 0, 0};
+  thread_local std::size_t fail_threshold = 0;
+
+  void* allocate(std::size_t n) noexcept {
+    if(n == 0){
+      n = 1;
+    }
+    if(fail_threshold != 0 && n >= fail_threshold){
+      return nullptr;
+    }
+    for(;;){
+      if(void* p = std::malloc(n)){
+        ++this_thread.allocations;
+        this_thread.bytes += n;
+        return p;
+      }
+      const std::new_handler handler = std::get_new_handler();
+      if(handler == nullptr){
+        return nullptr;
+      }
+      handler();
+    }
+  }
+
+  void deallocate(void* p) noexcept {
+    if(p != nullptr){
+      ++this_thread.deallocations;
+      std::free(p);
+    }
+  }
+
+  [[noreturn]] void out_of_memory() {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+  }
+
+#ifdef __cpp_aligned_new
+  void* allocate_aligned(std::size_t n, std::align_val_t al) noexcept {
+    const std::size_t align = static_cast<std::size_t>(al);
+    // aligned_alloc wants a size that's a multiple of the alignment.
+    const std::size_t rounded = (n + align - 1) / align * align;
+    if(fail_threshold != 0 && n >= fail_threshold){
+      return nullptr;
+    }
+    for(;;){
+      if(void* p = std::aligned_alloc(align, rounded ? rounded : align)){
+        ++this_thread.allocations;
+        this_thread.bytes += n;
+        return p;
+      }
+      const std::new_handler handler = std::get_new_handler();
+      if(handler == nullptr){
+        return nullptr;
+      }
+      handler();
+    }
+  }
+#endif
+}
+
+namespace alloc_hook {
+  counts current() noexcept {
+    return this_thread;
+  }
+
+  std::size_t set_fail_from(std::size_t bytes) noexcept {
+    const std::size_t previous = fail_threshold;
+    fail_threshold = bytes;
+    return previous;
+  }
+}
+
+void* operator new(std::size_t n) {
+  if(void* p = allocate(n)){
+    return p;
+  }
+  out_of_memory();
+}
+
+void* operator new[](std::size_t n) {
+  if(void* p = allocate(n)){
+    return p;
+  }
+  out_of_memory();
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  return allocate(n);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+  return allocate(n);
+}
+
+void operator delete(void* p) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  deallocate(p);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t n, std::align_val_t al) {
+  if(void* p = allocate_aligned(n, al)){
+    return p;
+  }
+  out_of_memory();
+}
+
+void* operator new[](std::size_t n, std::align_val_t al) {
+  if(void* p = allocate_aligned(n, al)){
+    return p;
+  }
+  out_of_memory();
+}
+
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return allocate_aligned(n, al);
+}
+
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+  return allocate_aligned(n, al);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  deallocate(p);
+}
+#endif
@@ -0,0 +1,89 @@
+/*
+ * alloc_hook.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef ALLOC_HOOK_HPP_R8NX2C4L
+#define ALLOC_HOOK_HPP_R8NX2C4L
+
+// Heap allocation counting for the tests and benchmarks. Linking
+// alloc_hook.cxx replaces the global operator new and delete (every form)
+// with ones that count into thread-local counters before going to malloc:
+//
+//   const auto n = alloc_hook::count([&] { return util::as_string(f); });
+//   CHECK(n.allocations == 1);
+//
+// Only operator new is seen: memory the C library mallocs itself (fopen's
+// FILE, exception objects) isn't counted. Not part of the library, which
+// must never replace the global allocator of a program using it.
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace alloc_hook {
+  struct counts {
+    std::uint64_t allocations;
+    std::uint64_t deallocations;
+    std::uint64_t bytes; // requested, over all allocations
+
+    counts operator-(const counts& o) const noexcept {
+      return {allocations - o.allocations, deallocations - o.deallocations, bytes - o.bytes};
+    }
+  };
+
+  // Totals for the calling thread since it started.
+  counts current() noexcept;
+
+  // From now on allocations of at least @p bytes on the calling thread fail
+  // (0: none do). Returns the previous setting.
+  std::size_t set_fail_from(std::size_t bytes) noexcept;
+
+  // Fails allocations of at least @p bytes on the calling thread while it
+  // lives: nothrow new returns nullptr, the others throw std::bad_alloc, or
+  // abort without exceptions.
+  class fail_from {
+  public:
+    explicit fail_from(std::size_t bytes) noexcept
+      : previous_(set_fail_from(bytes)) {
+    }
+
+    ~fail_from() {
+      set_fail_from(previous_);
+    }
+
+    fail_from(const fail_from&) = delete;
+    fail_from& operator=(const fail_from&) = delete;
+
+  private:
+    std::size_t previous_;
+  };
+
+  // Counts on the calling thread from construction to delta().
+  class scope {
+  public:
+    scope() noexcept
+      : start_(current()) {
+    }
+
+    counts delta() const noexcept {
+      return current() - start_;
+    }
+
+  private:
+    counts start_;
+  };
+
+  // Counts on the calling thread during @p fn(), whose result is discarded
+  // inside the count, so destroying it is included.
+  template<typename F>
+  counts count(F&& fn) {
+    const scope s;
+    static_cast<void>(std::forward<F>(fn)());
+    return s.delta();
+  }
+} // namespace alloc_hook
+
+#endif /* end of include guard: ALLOC_HOOK_HPP_R8NX2C4L */
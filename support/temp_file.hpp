@@ -0,0 +1,70 @@
+/*
+ * temp_file.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef TEMP_FILE_HPP_M4QZ8D2W
+#define TEMP_FILE_HPP_M4QZ8D2W
+
+// A file in /tmp for the tests and benchmarks, holding the given contents
+// and removed when the temp_file goes out of scope, however the test ends:
+//
+//   const support::temp_file file("key=value\n");
+//   REQUIRE(file);
+//   CHECK(util::map_file(file.path()).is_ok());
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+namespace support {
+  class temp_file {
+  public:
+    explicit temp_file(const std::string& contents = std::string()) {
+      const int fd = mkstemp(path_);
+      if (fd == -1) {
+        path_[0] = '\0';
+        return;
+      }
+      std::size_t written = 0;
+      while (written < contents.size()) {
+        const ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+        if (n <= 0) {
+          break;
+        }
+        written += static_cast<std::size_t>(n);
+      }
+      close(fd);
+      if (written != contents.size()) {
+        std::remove(path_);
+        path_[0] = '\0';
+      }
+    }
+
+    ~temp_file() {
+      if (path_[0] != '\0') {
+        std::remove(path_);
+      }
+    }
+
+    temp_file(const temp_file&) = delete;
+    temp_file& operator=(const temp_file&) = delete;
+
+    // False if the file couldn't be created or written.
+    explicit operator bool() const noexcept {
+      return path_[0] != '\0';
+    }
+
+    const char* path() const noexcept {
+      return path_;
+    }
+
+  private:
+    char path_[32] = "/tmp/result_test_XXXXXX";
+  };
+} // namespace support
+
+#endif /* !TEMP_FILE_HPP_M4QZ8D2W */
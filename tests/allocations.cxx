@@ -0,0 +1,136 @@
+/*
+ * allocations.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../support/alloc_hook.hpp"
+#include "../support/temp_file.hpp"
+#include "../utils.hpp"
+
+#include "doctest.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+
+// Each operation runs once before it's counted: with RESULT_STATS or
+// RESULT_TRACE a thread's first record allocates its table.
+
+namespace {
+  struct small_error {
+    const char* what;
+  };
+
+  util::Result<int, small_error> step(int v) {
+    if (v < 0) {
+      return util::Err(small_error{"negative"});
+    }
+    return util::Ok(v + 1);
+  }
+
+  util::Result<int, small_error> two_steps(int v) {
+    const int once = Try_(step(v));
+    return step(once);
+  }
+
+} // namespace
+
+TEST_CASE("Result operations don't allocate") {
+  const auto run = [] {
+    int sum = 0;
+    for (int v : {1, -1}) {
+      auto r = two_steps(v).apply([](int x) { return x * 2; });
+      sum += std::move(r).ok_or(0);
+      sum += two_steps(v).is_err();
+    }
+    return sum;
+  };
+  run();
+  const auto n = alloc_hook::count(run);
+  CHECK(n.allocations == 0);
+  CHECK(n.deallocations == 0);
+}
+
+TEST_CASE("moving a heap payload through a Result doesn't allocate") {
+  std::string payload(100, 'x');
+  const auto counted = alloc_hook::count([&] {
+    util::Result<std::string, small_error> r = util::Ok(std::move(payload));
+    payload = std::move(r).ok();
+    return 0;
+  });
+  CHECK(counted.allocations == 0);
+  CHECK(payload.size() == 100);
+}
+
+TEST_CASE("io_error creation and context don't allocate") {
+  const auto run = [] {
+    util::io_error e = util::io_error::from_errno("Failed to open file.", ENOENT, "/no/such/path");
+    e.context("first");
+    util::io_error copy = e;
+    copy.context("second");
+    return copy.errnum();
+  };
+  run();
+  CHECK(alloc_hook::count(run).allocations == 0);
+}
+
+TEST_CASE("util::open and as_string allocations") {
+  const support::temp_file file(std::string(100, 'x'));
+  REQUIRE(file);
+
+  const auto failed_open = [] {
+    return util::open("/no/such/dir/conf.ini", util::openmode::in)
+      .context("Failed to load conf.ini");
+  };
+  failed_open();
+  CHECK(alloc_hook::count(failed_open).allocations == 0);
+
+  // fopen() mallocs the FILE itself, which isn't counted.
+  const auto opened = [&] { return util::open(file.path(), util::openmode::in); };
+  opened();
+  CHECK(alloc_hook::count(opened).allocations == 0);
+
+  // Just the string's buffer.
+  const std::uint64_t buffers = 1;
+  auto f = util::open(file.path(), util::openmode::in).ok();
+  util::as_string(f);
+  std::rewind(f.get());
+  const auto read = alloc_hook::count([&] { return util::as_string(f); });
+  CHECK(read.allocations == buffers);
+  CHECK(read.deallocations == buffers);
+  CHECK(read.bytes >= 101);
+}
+
+TEST_CASE("try_make_buffer and as_buffer report running out of memory") {
+  const support::temp_file file(std::string(64 * 1024, 'x'));
+  REQUIRE(file);
+  auto f = util::open(file.path(), util::openmode::in).ok();
+
+  {
+    const alloc_hook::fail_from failing(4096);
+    auto made = util::try_make_buffer(1 << 20);
+    REQUIRE(made.is_err());
+    CHECK(made.err().errnum() == ENOMEM);
+    auto read = util::as_buffer(f);
+    REQUIRE(read.is_err());
+    CHECK(read.err().errnum() == ENOMEM);
+#if RESULT_EXCEPTIONS
+    auto str = util::try_make_string(1 << 20);
+    REQUIRE(str.is_err());
+    CHECK(str.err().errnum() == ENOMEM);
+#endif
+  }
+
+  std::rewind(f.get());
+  const auto read = alloc_hook::count([&] {
+    auto buf = util::as_buffer(f);
+    CHECK(buf.is_ok());
+    CHECK(buf.ok().size() == 64 * 1024);
+    CHECK(buf.ok().data()[0] == 'x');
+    return buf;
+  });
+  CHECK(read.allocations == 1);
+  CHECK(read.deallocations == 1);
+}
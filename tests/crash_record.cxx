@@ -0,0 +1,113 @@
+/*
+ * crash_record.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../contrib/backward.hpp"
+#include "../support/temp_file.hpp"
+
+#include "doctest.h"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+  // A fault in our own code rather than raise(): libc has no frame
+  // pointers to walk through.
+  __attribute__((noinline)) void crash_in_child() {
+    // Through a volatile so GCC can't see the constant address.
+    volatile int* volatile target = nullptr;
+    target[4] = 1;
+  }
+
+  bool within(void* addr, void (*fn)(), std::size_t size) {
+    const char* start = reinterpret_cast<const char*>(fn);
+    return static_cast<const char*>(addr) >= start &&
+           static_cast<const char*>(addr) < start + size;
+  }
+
+  // Forks a child that calls crash() with SignalHandling writing raw
+  // records to @p path, and waits for it to die.
+  template<typename F>
+  pid_t crash_child(const char* path, F crash) {
+    const pid_t child = fork();
+    if (child == 0) {
+      // Not "Crash record written to ..." on every run.
+      const int null = open("/dev/null", O_WRONLY);
+      if (null == -1 || dup2(null, 2) == -1) {
+        _exit(1);
+      }
+      backward::SignalHandling sh;
+      if (!sh.loaded() || !backward::SignalHandling::write_raw_records_to(path)) {
+        _exit(1);
+      }
+      crash();
+      _exit(1);
+    }
+    int status = 0;
+    if (child == -1 || waitpid(child, &status, 0) != child || !WIFSIGNALED(status)) {
+      return -1;
+    }
+    return child;
+  }
+} // namespace
+
+TEST_CASE("SignalHandling writes a raw crash record") {
+  const support::temp_file file;
+  REQUIRE(file);
+  const char* path = file.path();
+
+  const pid_t child = crash_child(path, crash_in_child);
+  REQUIRE(child != -1);
+
+  backward::RawCrashRecord record;
+  REQUIRE(record.load(path));
+  CHECK(record.header.signo == SIGSEGV);
+  CHECK(record.header.pid == child);
+  CHECK(record.frames.size() > 0);
+
+  // The child had the same mappings as this process.
+  Dl_info self;
+  REQUIRE(dladdr(reinterpret_cast<void*>(&crash_in_child), &self) != 0);
+  bool found_self = false;
+  for (const auto& object : record.objects) {
+    found_self |= reinterpret_cast<void*>(object.second) == self.dli_fbase;
+  }
+  CHECK(found_self);
+  bool found_frame = false;
+  for (void* frame : record.frames) {
+    found_frame |= within(frame, &crash_in_child, 256);
+  }
+  CHECK(found_frame);
+}
+
+TEST_CASE("SignalHandling records the frames of a thread that crashes") {
+  const support::temp_file file;
+  REQUIRE(file);
+  const char* path = file.path();
+
+  // The thread never walked its stack before, so with FP_UNWIND=1 the
+  // handler bounds the walk without asking pthread_getattr_np().
+  REQUIRE(crash_child(path, [] {
+    std::thread crashing(crash_in_child);
+    crashing.join();
+  }) != -1);
+
+  backward::RawCrashRecord record;
+  REQUIRE(record.load(path));
+  CHECK(record.header.tid != record.header.pid);
+  bool found_frame = false;
+  for (void* frame : record.frames) {
+    found_frame |= within(frame, &crash_in_child, 256);
+  }
+  CHECK(found_frame);
+}
@@ -0,0 +1,139 @@
+/*
+ * error_log.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../error_log.hpp"
+#include "../utils.hpp"
+
+#include "doctest.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+  struct plain_error {
+    const char* what;
+  };
+
+  // Sends the log to a temporary file for the life of the test.
+  struct captured_log {
+    std::FILE* file = std::tmpfile();
+
+    captured_log() {
+      REQUIRE(file != nullptr);
+      util::errlog::flush();
+      util::errlog::set_output(fileno(file));
+    }
+
+    ~captured_log() {
+      util::errlog::flush();
+      util::errlog::set_output(2);
+      std::fclose(file);
+    }
+
+    std::vector<std::string> lines() {
+      util::errlog::flush();
+      std::vector<std::string> out;
+      std::rewind(file);
+      std::string line;
+      for (int c; (c = std::fgetc(file)) != EOF;) {
+        if (c == '\n') {
+          out.push_back(line);
+          line.clear();
+        } else {
+          line += static_cast<char>(c);
+        }
+      }
+      return out;
+    }
+  };
+
+  bool contains(const std::string& s, const char* part) {
+    return s.find(part) != std::string::npos;
+  }
+} // namespace
+
+TEST_CASE("log_if_err writes the error's context and call site") {
+  captured_log log;
+
+  util::Result<int, util::io_error> ok = util::Ok(1);
+  CHECK(!util::log_if_err(ok));
+  util::Result<int, util::io_error> failed =
+    util::Err(util::io_error::from_errno("Failed to open file.", ENOENT, "/no/such/file"));
+  const unsigned line = __LINE__ + 1;
+  CHECK(util::log_if_err(failed));
+  util::Result<int, plain_error> plain = util::Err(plain_error{"no context"});
+  CHECK(util::log_if_err(plain));
+
+  const std::vector<std::string> lines = log.lines();
+  REQUIRE(lines.size() == 2);
+  CHECK(contains(lines[0], ("error_log.cxx:" + std::to_string(line) + ": ").c_str()));
+  CHECK(contains(lines[0], "/no/such/file"));
+  CHECK(contains(lines[1], "error without context"));
+}
+
+TEST_CASE("log_if_err rate limits identical messages per site") {
+  captured_log log;
+  const util::errlog::counters before = util::errlog::stats();
+
+  util::Result<int, plain_error> failed = util::Err(plain_error{"x"});
+  for (unsigned i = 0; i < util::errlog::burst + 5; ++i) {
+    util::log_if_err(failed);
+  }
+
+  const std::vector<std::string> lines = log.lines();
+  REQUIRE(lines.size() == util::errlog::burst + 1);
+  CHECK(contains(lines.back(), "[5 more suppressed]"));
+  CHECK(util::errlog::stats().suppressed - before.suppressed == 5);
+}
+
+TEST_CASE("log_if_err from many threads loses nothing it doesn't count") {
+  captured_log log;
+  const util::errlog::counters before = util::errlog::stats();
+
+  // Distinct sites per thread so nothing is suppressed.
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t) {
+    threads.emplace_back([t] {
+      util::Result<int, plain_error> failed = util::Err(plain_error{"threaded"});
+      for (unsigned i = 0; i < 1000; ++i) {
+        util::log_if_err(failed, util::stats::site{"thread", t * 1000 + i});
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  const std::size_t written = log.lines().size();
+  const util::errlog::counters after = util::errlog::stats();
+  CHECK(after.logged - before.logged == written);
+  CHECK(after.logged - before.logged + after.dropped - before.dropped == 4000);
+}
+
+TEST_CASE("log_if_err doesn't count lines that failed to write") {
+  const int full = open("/dev/full", O_WRONLY);
+  REQUIRE(full != -1);
+  util::errlog::flush();
+  util::errlog::set_output(full);
+  const util::errlog::counters before = util::errlog::stats();
+
+  util::Result<int, plain_error> failed = util::Err(plain_error{"lost"});
+  util::log_if_err(failed);
+  util::errlog::flush();
+
+  const util::errlog::counters after = util::errlog::stats();
+  CHECK(after.logged - before.logged == 1);
+  CHECK(after.written == before.written);
+  util::errlog::set_output(2);
+  close(full);
+}
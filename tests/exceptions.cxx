@@ -0,0 +1,95 @@
+/*
+ * exceptions.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../result.hpp"
+
+// Nothing to test in the -fno-exceptions build.
+#if RESULT_EXCEPTIONS
+#include "../exceptions.hpp"
+
+#include "doctest.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+  struct not_an_exception {
+    int code;
+  };
+
+  int parse(int i) {
+    if (i < 0) {
+      throw std::invalid_argument("negative");
+    }
+    if (i == 0) {
+      throw std::logic_error("zero");
+    }
+    if (i == 1) {
+      throw not_an_exception{1};
+    }
+    return i * 2;
+  }
+} // namespace
+
+TEST_CASE("catch_as_result") {
+  auto r = util::catch_as_result<std::logic_error>([] { return parse(4); });
+  REQUIRE(r.is_ok());
+  CHECK(r.ok() == 8);
+
+  // invalid_argument derives from logic_error.
+  auto r2 = util::catch_as_result<std::logic_error>([] { return parse(-1); });
+  REQUIRE(r2.is_err());
+  CHECK(std::strcmp(get_context(r2.err()), "negative") == 0);
+
+  // First matching type wins.
+  auto r3 = util::catch_as_result<std::invalid_argument, std::logic_error>(
+    [] { return parse(-1); });
+  CHECK(r3.err().index == 0);
+  auto r4 = util::catch_as_result<std::invalid_argument, std::logic_error>(
+    [] { return parse(0); });
+  CHECK(r4.err().index == 1);
+
+  auto r5 = util::catch_as_result<not_an_exception>([] { return parse(1); });
+  REQUIRE(r5.is_err());
+  CHECK(r5.err().what == nullptr);
+
+  bool propagated = false;
+  try {
+    util::catch_as_result<std::invalid_argument>([] { return parse(0); });
+  } catch (const std::logic_error&) {
+    propagated = true;
+  }
+  CHECK(propagated);
+}
+
+TEST_CASE("into_exception") {
+  CHECK(util::into_exception(util::catch_as_result<std::logic_error>(
+          [] { return parse(2); })) == 4);
+
+  bool rethrown = false;
+  try {
+    util::into_exception(
+      util::catch_as_result<std::logic_error>([] { return parse(-1); }));
+  } catch (const std::invalid_argument& e) {
+    rethrown = std::strcmp(e.what(), "negative") == 0;
+  }
+  CHECK(rethrown);
+
+  bool wrapped = false;
+  try {
+    util::into_exception(util::Result<int, not_an_exception>{
+      util::Err(not_an_exception{3})});
+  } catch (const util::result_error<not_an_exception>& e) {
+    wrapped = e.error.code == 3;
+  }
+  CHECK(wrapped);
+
+  int i = 5;
+  util::Result<int&, not_an_exception> ref{util::Ok(i)};
+  CHECK(&util::into_exception(std::move(ref)) == &i);
+}
+#endif
@@ -0,0 +1,137 @@
+/*
+ * fault.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../utils.hpp"
+
+// Faults are only injected when built with RESULT_FAULTS, see `make faults`.
+#if RESULT_FAULTS
+#include "../fault.hpp"
+#include "../support/temp_file.hpp"
+#include "doctest.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace {
+  using util::fault::point;
+
+  struct plain_error {
+    int code = 7;
+  };
+
+  util::Result<int, plain_error> plain_ok() {
+    return util::Ok(1);
+  }
+
+  util::Result<int, plain_error> plain_twice() {
+    const int v = Try_(plain_ok());
+    return util::Ok(v + 1);
+  }
+
+  util::IOError<std::string> read_file(const char* path) {
+    const util::fstream_ptr f = Try_(util::open(path, util::openmode::in));
+    return util::as_string(f);
+  }
+
+  std::vector<bool> decisions(point p, std::size_t n) {
+    std::vector<bool> out;
+    for (std::size_t i = 0; i < n; ++i) {
+      out.push_back(util::fault::should_fail(p));
+    }
+    return out;
+  }
+
+  // Clears every probability before and after the test.
+  struct clean_faults {
+    clean_faults() {
+      util::fault::reset();
+    }
+    ~clean_faults() {
+      util::fault::reset();
+    }
+  };
+} // namespace
+
+TEST_CASE("RESULT_FAULTS: utils fail with EIO at their injection points") {
+  clean_faults clean;
+  const support::temp_file file("key=value\n");
+  REQUIRE(file);
+  const char* path = file.path();
+
+  CHECK(read_file(path).is_ok());
+
+  for (const char* name : {"open", "file_size", "as_string"}) {
+    REQUIRE(util::fault::set(name, 1.0));
+    auto res = read_file(path);
+    REQUIRE(res.is_err());
+    CHECK(res.err().errnum() == EIO);
+    util::fault::set(name, 0.0);
+  }
+  CHECK(util::fault::stats(point::open).injected == 1);
+  CHECK(util::fault::stats(point::file_size).injected == 1);
+  CHECK(util::fault::stats(point::as_string).injected == 1);
+
+  CHECK(read_file(path).is_ok());
+
+  util::fault::set(point::map_file, 1.0);
+  auto view = util::map_file(path);
+  REQUIRE(view.is_err());
+  CHECK(view.err().errnum() == EIO);
+  util::fault::set(point::map_file, 0.0);
+  CHECK(util::map_file(path).is_ok());
+}
+
+TEST_CASE("RESULT_FAULTS: Try_ fails ok results with an injected error") {
+  clean_faults clean;
+  util::fault::set(point::try_, 1.0);
+
+  auto plain = plain_twice();
+  REQUIRE(plain.is_err());
+  CHECK(plain.err().code == 7);
+
+  CHECK(util::open("/", util::openmode::in).is_ok());
+  auto read = read_file("/");
+  REQUIRE(read.is_err());
+  CHECK(std::strcmp(read.err().what(), "Injected fault.") == 0);
+
+  util::fault::set(point::try_, 0.0);
+  CHECK(plain_twice().is_ok());
+}
+
+TEST_CASE("RESULT_FAULTS: the same seed fails the same calls") {
+  clean_faults clean;
+  util::fault::set(point::try_, 0.3);
+
+  util::fault::set_seed(42);
+  const std::vector<bool> first = decisions(point::try_, 10000);
+  util::fault::set_seed(42);
+  const std::vector<bool> again = decisions(point::try_, 10000);
+  util::fault::set_seed(43);
+  const std::vector<bool> other = decisions(point::try_, 10000);
+
+  CHECK(first == again);
+  CHECK(first != other);
+  const auto failed = util::fault::stats(point::try_).injected;
+  CHECK(failed > 2800);
+  CHECK(failed < 3200);
+  CHECK(util::fault::stats(point::try_).calls == 10000);
+}
+
+TEST_CASE("RESULT_FAULTS: configure reads RESULT_FAULTS style lists") {
+  clean_faults clean;
+  CHECK(util::fault::configure("open=0.25,try=1e-3,seed=0x2a"));
+  CHECK(util::fault::probability(point::open) == 0.25);
+  CHECK(util::fault::probability(point::try_) == 0.001);
+  CHECK(util::fault::probability(point::as_string) == 0.0);
+
+  CHECK(!util::fault::configure("open=2,nope=0.5"));
+  CHECK(util::fault::probability(point::open) == 1.0);
+  CHECK(!util::fault::configure("open"));
+  CHECK(!util::fault::configure("open=0.5x"));
+}
+#endif
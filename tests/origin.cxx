@@ -0,0 +1,141 @@
+/*
+ * origin.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../result.hpp"
+
+// Origins are only captured when built with RESULT_ORIGIN, see `make origin`.
+#if RESULT_ORIGIN
+#include "doctest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+  struct origin_error {
+    const char* what;
+  };
+
+  __attribute__((noinline)) util::Result<int, origin_error> make_error() {
+    return util::Err(origin_error{"made here"});
+  }
+
+  __attribute__((noinline)) util::Result<int, origin_error> make_other_error() {
+    return util::Err(origin_error{"made there"});
+  }
+
+  __attribute__((noinline)) util::Result<int, origin_error> pass_up() {
+    const int v = Try_(make_error());
+    return util::Ok(v);
+  }
+
+  void* innermost(util::origin::id i) {
+    util::origin::trace t;
+    return util::origin::lookup(i, t) ? t.frames[0] : nullptr;
+  }
+
+  struct sample_every {
+    const unsigned saved = util::origin::sample_every();
+
+    explicit sample_every(unsigned n) {
+      util::origin::set_sample_every(n);
+    }
+
+    ~sample_every() {
+      util::origin::set_sample_every(saved);
+    }
+  };
+} // namespace
+
+TEST_CASE("RESULT_ORIGIN keeps an Err's origin as it's passed on") {
+  const sample_every all(1);
+
+  auto made = make_error();
+  REQUIRE(made.err_origin() != 0);
+  CHECK(made.err_origin() != make_other_error().err_origin());
+
+  auto copied = made;
+  CHECK(copied.err_origin() == made.err_origin());
+  auto moved = std::move(copied);
+  CHECK(moved.err_origin() == made.err_origin());
+
+  // Through Try_ and apply() the origin stays where the error was made,
+  // which is make_error's call into Result, not pass_up's.
+  auto passed = pass_up();
+  REQUIRE(passed.is_err());
+  CHECK(innermost(passed.err_origin()) == innermost(made.err_origin()));
+
+  auto applied = make_error().apply([](int v) { return v + 1; });
+  REQUIRE(applied.is_err());
+  CHECK(innermost(applied.err_origin()) == innermost(made.err_origin()));
+}
+
+TEST_CASE("RESULT_ORIGIN stores each distinct trace once") {
+  const sample_every all(1);
+
+  // The same frames each time, caller included. The first round may add
+  // the trace, the second must only find it.
+  util::origin::store_stats after_first = {};
+  for (int round = 0; round < 2; ++round) {
+    util::origin::id ids[1000];
+    for (util::origin::id& i : ids) {
+      i = make_error().err_origin();
+    }
+    CHECK(ids[0] != 0);
+    CHECK(std::count(ids, ids + 1000, ids[0]) == 1000);
+    if (round == 0) {
+      after_first = util::origin::stats();
+    }
+  }
+  CHECK(util::origin::stats().unique == after_first.unique);
+
+  util::origin::trace t;
+  CHECK(!util::origin::lookup(0, t));
+  CHECK(!util::origin::lookup(util::origin::store_capacity + 1, t));
+}
+
+TEST_CASE("RESULT_ORIGIN samples every nth Err") {
+  {
+    const sample_every none(0);
+    CHECK(make_error().err_origin() == 0);
+  }
+
+  const sample_every third(3);
+  int sampled = 0;
+  for (int i = 0; i < 9; ++i) {
+    sampled += make_error().err_origin() != 0;
+  }
+  CHECK(sampled == 3);
+}
+
+TEST_CASE("RESULT_ORIGIN prints one line per frame") {
+  const sample_every all(1);
+  auto made = make_error();
+
+  std::FILE* out = std::tmpfile();
+  REQUIRE(out != nullptr);
+  const auto printed = [&] {
+    std::rewind(out);
+    util::origin::print(made.err_origin(), out);
+    const long end = std::ftell(out);
+    std::rewind(out);
+    std::string text;
+    for (int c; std::ftell(out) < end && (c = std::fgetc(out)) != EOF;) {
+      text += static_cast<char>(c);
+    }
+    return text;
+  };
+  const std::string first = printed();
+  util::origin::trace t;
+  REQUIRE(util::origin::lookup(made.err_origin(), t));
+  CHECK(static_cast<unsigned>(std::count(first.begin(), first.end(), '\n')) == t.count);
+  // The second time comes from what the first resolved.
+  CHECK(printed() == first);
+  std::fclose(out);
+}
+#endif
@@ -0,0 +1,131 @@
+/*
+ * result_audit.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../result.hpp"
+
+// Nothing is counted unless built with RESULT_AUDIT, see `make audit`.
+#if RESULT_AUDIT
+#include "../support/temp_file.hpp"
+#include "../utils.hpp"
+
+#include "doctest.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+  using util::audit::action;
+  using util::audit::payload;
+
+  struct audit_error {
+    const char* what;
+  };
+
+  std::uint64_t count_at(unsigned line, const char* op, payload p, action a) {
+    std::uint64_t n = 0;
+    for (const auto& e : util::audit::snapshot()) {
+      if (e.at.line == line && (op == nullptr || std::strcmp(e.at.op, op) == 0) &&
+          std::strcmp(e.at.file, __FILE__) == 0) {
+        n += e.count(p, a);
+      }
+    }
+    return n;
+  }
+
+  util::Result<int, std::string> fail() {
+    return util::Err(std::string("failed"));
+  }
+
+  const unsigned try_line = __LINE__ + 2;
+  util::Result<int, std::string> pass_up() {
+    const int v = Try_(fail());
+    return util::Ok(v + 1);
+  }
+
+  // example2.cxx's two(), minus the abort on failure.
+  util::IOError<std::string> two(const char* path) {
+    return util::open(path, util::openmode::in)
+      .context("Failed to load conf.ini")
+      .apply(util::as_string);
+  }
+
+  // two() with an error that's counted: io_error is trivially copyable.
+  struct open_error {
+    std::string path;
+  };
+
+  util::Result<std::string, open_error> open_named(const char* path) {
+    if (std::strchr(path, '/') != nullptr) {
+      return util::Err(open_error{path});
+    }
+    return util::Ok(std::string(path));
+  }
+
+  util::Result<std::string, open_error> two_named(const char* path) {
+    return open_named(path).apply([](std::string& name) { return name + ".ini"; });
+  }
+} // namespace
+
+TEST_CASE("RESULT_AUDIT: open, context, apply and ok copy no payloads") {
+  const support::temp_file file("key=value\n");
+  REQUIRE(file);
+  const char* path = file.path();
+
+  util::audit::reset();
+  {
+    std::string contents = two(path).ok("Failed to read file.");
+    CHECK(contents == "key=value\n");
+  }
+
+  CHECK(util::audit::total(payload::ok, action::copy) == 0);
+  CHECK(util::audit::total(payload::err, action::copy) == 0);
+  CHECK(util::audit::total(payload::ok, action::move) > 0);
+}
+
+TEST_CASE("RESULT_AUDIT: a failed open propagates its error without copies") {
+  util::audit::reset();
+  CHECK(two_named("/no/such/file").is_err());
+
+  CHECK(util::audit::total(payload::ok, action::copy) == 0);
+  CHECK(util::audit::total(payload::err, action::copy) == 0);
+  // Made, then moved out through apply().
+  CHECK(util::audit::total(payload::err, action::move) >= 2);
+}
+
+TEST_CASE("RESULT_AUDIT: Try_ and apply move errors up") {
+  util::audit::reset();
+  const unsigned apply_line = __LINE__ + 1;
+  auto res = pass_up().apply([](int v) { return v * 2; });
+  REQUIRE(res.is_err());
+  CHECK(res.err() == "failed");
+
+  CHECK(util::audit::total(payload::err, action::copy) == 0);
+  // "Err", or "propagate" where RESULT_ORIGIN hands the origin along too.
+  CHECK(count_at(try_line, nullptr, payload::err, action::move) == 1);
+  CHECK(count_at(apply_line, "propagate", payload::err, action::move) == 1);
+}
+
+TEST_CASE("RESULT_AUDIT attributes copies to their call site") {
+  util::Result<std::string, audit_error> res = util::Ok(std::string("ok"));
+
+  util::audit::reset();
+  const unsigned copy_line = __LINE__ + 1;
+  util::Result<std::string, audit_error> copied = res;
+  const unsigned ok_or_line = __LINE__ + 1;
+  const std::string alt = res.ok_or(std::string("alt"));
+  const unsigned moved_line = __LINE__ + 1;
+  util::Result<std::string, audit_error> moved = std::move(copied);
+
+  CHECK(alt == "ok");
+  CHECK(moved.ok() == "ok");
+  CHECK(count_at(copy_line, "copy", payload::ok, action::copy) == 1);
+  CHECK(count_at(ok_or_line, "ok_or", payload::ok, action::copy) == 1);
+  CHECK(count_at(moved_line, "move", payload::ok, action::move) == 1);
+  CHECK(count_at(moved_line, "move", payload::ok, action::copy) == 0);
+  CHECK(util::audit::total(payload::ok, action::copy, "audit_error") == 2);
+}
+#endif
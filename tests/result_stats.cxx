@@ -0,0 +1,110 @@
+/*
+ * result_stats.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../result.hpp"
+
+// Nothing is counted unless built with RESULT_STATS, see `make stats`.
+#if RESULT_STATS
+#include "doctest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  using util::stats::event;
+
+  // Not an int: with C++20 an aggregate of int is constructible from one.
+  struct test_error {
+    const char* what;
+  };
+
+  const unsigned fail_line = __LINE__ + 2;
+  util::Result<int, test_error> fail(int) {
+    return util::Err(test_error{"fail"});
+  }
+
+  const unsigned convert_line = __LINE__ + 2;
+  util::Result<int, const char*> fail_implicitly() {
+    return "converted";
+  }
+
+  const unsigned try_line = __LINE__ + 2;
+  util::Result<int, test_error> pass_up(int e) {
+    auto v = Try_(fail(e));
+    return util::Ok(v);
+  }
+
+  std::uint64_t count_at(unsigned line, event what) {
+    for (const auto& c : util::stats::snapshot()) {
+      if (c.line == line && c.what == what && std::strcmp(c.file, __FILE__) == 0) {
+        return c.count;
+      }
+    }
+    return 0;
+  }
+} // namespace
+
+TEST_CASE("RESULT_STATS counts Errs at their call site") {
+  const auto errs      = count_at(fail_line, event::err);
+  const auto converted = count_at(convert_line, event::err);
+  const auto passed_up = count_at(try_line, event::propagate);
+
+  for (int i = 0; i < 3; ++i) {
+    CHECK(pass_up(i).is_err());
+  }
+  CHECK(fail_implicitly().is_err());
+
+  CHECK(count_at(fail_line, event::err) == errs + 3);
+  CHECK(count_at(convert_line, event::err) == converted + 1);
+  CHECK(count_at(try_line, event::propagate) == passed_up + 3);
+  // Try_ rewraps the error, which isn't a new Err.
+  CHECK(count_at(try_line, event::err) == 0);
+
+  const unsigned apply_line = __LINE__ + 1;
+  auto applied = fail(1).apply([](int&& i) { return i + 1; });
+  CHECK(applied.is_err());
+  CHECK(count_at(apply_line, event::propagate) == 1);
+}
+
+TEST_CASE("RESULT_STATS merges counts from exited threads") {
+  const auto before = count_at(fail_line, event::err);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 100; ++i) {
+        (void)fail(i);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  CHECK(count_at(fail_line, event::err) == before + 400);
+}
+
+TEST_CASE("RESULT_STATS dump_fd") {
+  (void)fail(1);
+  std::FILE* f = std::tmpfile();
+  REQUIRE(f != nullptr);
+  REQUIRE(util::stats::dump_fd(fileno(f)));
+
+  std::string text;
+  std::rewind(f);
+  char buf[256];
+  while (std::fgets(buf, sizeof(buf), f) != nullptr) {
+    text += buf;
+  }
+  std::fclose(f);
+
+  char expected[256];
+  std::snprintf(expected, sizeof(expected), "\terr\t%s:%u\n", __FILE__, fail_line);
+  CHECK(text.find(expected) != std::string::npos);
+}
+#endif
@@ -0,0 +1,116 @@
+/*
+ * source_file.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../contrib/backward.hpp"
+#include "../support/temp_file.hpp"
+
+#include "doctest.h"
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+  using lines_t = backward::SourceFile::lines_t;
+
+  // What index_lines() finds, one byte at a time.
+  std::vector<size_t> line_starts(const std::string& data) {
+    std::vector<size_t> starts;
+    if (data.empty()) {
+      return starts;
+    }
+    starts.push_back(0);
+    for (size_t i = 0; i + 1 < data.size(); ++i) {
+      if (data[i] == '\n') {
+        starts.push_back(i + 1);
+      }
+    }
+    return starts;
+  }
+
+  std::vector<size_t> index_lines(const std::string& data) {
+    std::vector<size_t> starts;
+    backward::details::index_lines(data.data(), data.size(), starts);
+    return starts;
+  }
+
+  // A file with @p contents for as long as it lives.
+  struct source {
+    const support::temp_file file;
+
+    explicit source(const std::string& contents) : file(contents) {
+      CHECK(file);
+    }
+
+    lines_t lines(unsigned start, unsigned count) const {
+      backward::SourceFile source_file(file.path());
+      CHECK(source_file.is_open());
+      return source_file.get_lines(start, count);
+    }
+  };
+
+  lines_t numbered(std::initializer_list<std::pair<unsigned, std::string>> lines) {
+    return lines_t(lines.begin(), lines.end());
+  }
+} // namespace
+
+TEST_CASE("index_lines finds every line start, whatever the size") {
+  CHECK(index_lines("").empty());
+  CHECK(index_lines("\n") == std::vector<size_t>{0});
+  CHECK(index_lines("a\nb") == (std::vector<size_t>{0, 2}));
+  CHECK(index_lines("a\nb\n") == (std::vector<size_t>{0, 2}));
+  CHECK(index_lines("a\r\nb\r\n") == (std::vector<size_t>{0, 3}));
+
+  // Newlines on both sides of each 16 byte block, and in the tail.
+  for (size_t size = 1; size <= 70; ++size) {
+    std::string data(size, 'x');
+    for (size_t i = 0; i < size; i += 7) {
+      data[i] = '\n';
+    }
+    data[size - 1] = size % 2 ? '\n' : 'x';
+    if (size > 16) {
+      data[15] = data[16] = '\n';
+    }
+    CHECK(index_lines(data) == line_starts(data));
+  }
+}
+
+TEST_CASE("SourceFile::get_lines returns the lines asked for") {
+  const source small("one\ntwo\n");
+  CHECK(small.lines(1, 2) == numbered({{1, "one"}, {2, "two"}}));
+  CHECK(small.lines(2, 5) == numbered({{2, "two"}}));
+
+  const source large("first line\nsecond line\nthird line\nfourth line\nlast");
+  CHECK(large.lines(2, 2) == numbered({{2, "second line"}, {3, "third line"}}));
+  // No newline at the end.
+  CHECK(large.lines(4, 3) == numbered({{4, "fourth line"}, {5, "last"}}));
+}
+
+TEST_CASE("SourceFile::get_lines keeps CRs, as getline() would") {
+  const source crlf("int a;\r\nint b;\r\n");
+  CHECK(crlf.lines(1, 2) == numbered({{1, "int a;\r"}, {2, "int b;\r"}}));
+}
+
+TEST_CASE("SourceFile::get_lines at the ends of the file") {
+  const source file("a\nb\nc\n");
+  // Line 0 is before the first: one line fewer.
+  CHECK(file.lines(0, 2) == numbered({{1, "a"}}));
+  CHECK(file.lines(3, 2) == numbered({{3, "c"}}));
+  CHECK(file.lines(4, 2).empty());
+  // A snippet centred on line 1 starts below it.
+  CHECK(file.lines(1u - 2u, 4).empty());
+
+  const source empty("");
+  CHECK(empty.lines(1, 3).empty());
+}
+
+TEST_CASE("SourceFile::get_lines drops blank lines around the snippet") {
+  const source file("\n  \nbody\n\nmore\n\n \n\n");
+  CHECK(file.lines(1, 8) == numbered({{3, "body"}, {4, ""}, {5, "more"}}));
+  CHECK(file.lines(6, 3).empty());
+}
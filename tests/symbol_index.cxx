@@ -0,0 +1,74 @@
+/*
+ * symbol_index.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../contrib/backward.hpp"
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+
+#if BACKWARD_HAS_DW == 1
+namespace {
+  __attribute__((noinline)) backward::StackTrace here() {
+    backward::StackTrace st;
+    st.load_here(8);
+    return st;
+  }
+
+  __attribute__((noinline)) backward::StackTrace one_deeper() {
+    backward::StackTrace st = here();
+    asm volatile("" ::: "memory");
+    return st;
+  }
+} // namespace
+
+TEST_CASE("backward resolves through the symbol index like through the DWARF") {
+  backward::StackTrace st = one_deeper();
+  REQUIRE(st.size() > 2);
+
+  // The index, built here rather than in preindex_symbols()' thread.
+  backward::details::dw_build_index(nullptr);
+  const backward::details::dw_index* index = backward::details::dw_shared().built_index();
+  REQUIRE(index != nullptr);
+
+  // Where each frame's object was loaded: a resolver given these walks the
+  // DWARF without looking at the index or the cache.
+  std::vector<std::pair<std::string, uintptr_t>> objects;
+  for (size_t i = 0; i < st.size(); ++i) {
+    Dl_info info;
+    if (dladdr(st[i].addr, &info) == 0 || info.dli_fname == nullptr) {
+      continue;
+    }
+    const std::pair<std::string, uintptr_t> object(
+      info.dli_fname, reinterpret_cast<uintptr_t>(info.dli_fbase));
+    if (std::find(objects.begin(), objects.end(), object) == objects.end()) {
+      objects.push_back(object);
+    }
+  }
+  backward::TraceResolver dwarf;
+  REQUIRE(dwarf.load_objects(objects.begin(), objects.end()));
+
+  backward::TraceResolver indexed;
+  unsigned with_source = 0;
+  for (size_t i = 0; i < st.size(); ++i) {
+    const backward::ResolvedTrace a = indexed.resolve(st[i]);
+    const backward::ResolvedTrace b = dwarf.resolve(st[i]);
+    CHECK(a.object_function == b.object_function);
+    CHECK(a.source.filename == b.source.filename);
+    CHECK(a.source.line == b.source.line);
+    backward::details::dw_index::match m;
+    with_source += index->find(reinterpret_cast<Dwarf_Addr>(st[i].addr), m) && m.filename;
+  }
+  // This file's frames at least.
+  CHECK(with_source >= 3);
+}
+#endif
@@ -0,0 +1,100 @@
+/*
+ * timing.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../timing.hpp"
+
+#include "doctest.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+  using util::timing::histogram;
+
+  struct timing_error {
+    const char* what;
+  };
+
+  util::Result<int, timing_error> succeed_or_fail(bool fail) {
+    if (fail) {
+      return util::Err(timing_error{"fail"});
+    }
+    return util::Ok(1);
+  }
+
+  const util::timing::site_histograms* find(
+    const std::vector<util::timing::site_histograms>& all, const char* name) {
+    for (const auto& s : all) {
+      if (std::strcmp(s.name, name) == 0) {
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+} // namespace
+
+TEST_CASE("histogram buckets") {
+  CHECK(histogram::bucket_of(0) == 0);
+  CHECK(histogram::bucket_of(31) == 31);
+  CHECK(histogram::bucket_of(~std::uint64_t{0}) == histogram::bucket_count - 1);
+
+  for (std::uint64_t v = 1; v < (std::uint64_t{1} << 41); v = v * 3 / 2 + 1) {
+    const unsigned b = histogram::bucket_of(v);
+    CHECK(histogram::bucket_lower(b) <= v);
+    CHECK(v <= histogram::bucket_upper(b));
+    // Never wider than 1/16 of the values in it.
+    CHECK(histogram::bucket_upper(b) - histogram::bucket_lower(b) <=
+          histogram::bucket_lower(b) / 16);
+    if (b + 1 < histogram::bucket_count) {
+      CHECK(histogram::bucket_upper(b) + 1 == histogram::bucket_lower(b + 1));
+    }
+  }
+}
+
+TEST_CASE("histogram quantiles and merge") {
+  histogram h;
+  for (std::uint64_t v = 1; v <= 1000; ++v) {
+    h.record(v);
+  }
+  CHECK(h.count() == 1000);
+  CHECK(h.max() == 1000);
+  CHECK(h.sum() == 500500);
+  CHECK(h.quantile(0.5) >= 500);
+  CHECK(h.quantile(0.5) <= 500 + 500 / 16);
+  CHECK(h.quantile(0.99) >= 990);
+  CHECK(h.quantile(1.0) == 1000);
+
+  histogram other;
+  other.record(5000, 10);
+  h.merge(other);
+  CHECK(h.count() == 1010);
+  CHECK(h.max() == 5000);
+  CHECK(h.quantile(1.0) == 5000);
+}
+
+TEST_CASE("timed splits ok and err") {
+  static util::timing::site site{"tests/timed"};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 10; ++i) {
+        auto r = util::timed(site, [&] { return succeed_or_fail(i % 5 == 0); });
+        CHECK(r.is_err() == (i % 5 == 0));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  const auto all = util::timing::snapshot();
+  const auto* s  = find(all, "tests/timed");
+  REQUIRE(s != nullptr);
+  CHECK(s->ok.count() == 24);
+  CHECK(s->err.count() == 6);
+}
@@ -0,0 +1,101 @@
+/*
+ * trace.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../result.hpp"
+
+// Err events are only emitted when built with RESULT_TRACE, see `make trace`.
+#if RESULT_TRACE
+#include "../support/temp_file.hpp"
+#include "../utils.hpp"
+
+#include "doctest.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+  struct trace_error {
+    const char* what;
+  };
+
+  util::Result<int, trace_error> step(bool fail) {
+    if (fail) {
+      return util::Err(trace_error{"step failed"});
+    }
+    return util::Ok(1);
+  }
+
+  std::string read_all(const char* path) {
+    std::string text;
+    if (std::FILE* f = std::fopen(path, "r")) {
+      char buf[4096];
+      std::size_t n;
+      while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, n);
+      }
+      std::fclose(f);
+    }
+    return text;
+  }
+
+  std::size_t occurrences(const std::string& text, const std::string& needle) {
+    std::size_t n = 0;
+    for (auto pos = text.find(needle); pos != std::string::npos;
+         pos = text.find(needle, pos + 1)) {
+      ++n;
+    }
+    return n;
+  }
+} // namespace
+
+TEST_CASE("RESULT_TRACE writes spans and Errs as a Chrome trace") {
+  std::thread([] {
+    (void)util::traced("tests/outer", [] {
+      return util::traced("tests/inner", [] { return step(true); });
+    });
+    (void)util::traced("tests/outer", [] { return step(false); });
+  }).join();
+  (void)util::open("/no/such/file", util::openmode::in);
+
+  const support::temp_file file;
+  REQUIRE(file);
+  const char* path = file.path();
+  REQUIRE(util::trace::flush(path));
+  const std::string json = read_all(path);
+
+  CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+  CHECK(json.find("]") != std::string::npos);
+  CHECK(occurrences(json, "\"name\":\"tests/outer\"") == 4);
+  CHECK(occurrences(json, "\"name\":\"tests/inner\"") == 2);
+  CHECK(occurrences(json, "\"outcome\":\"err\"") >= 2);
+  CHECK(occurrences(json, "\"outcome\":\"ok\"") >= 1);
+  CHECK(json.find("\"name\":\"Err\"") != std::string::npos);
+  CHECK(json.find(__FILE__) != std::string::npos);
+  CHECK(occurrences(json, "\"name\":\"util::open\"") >= 2);
+}
+
+TEST_CASE("RESULT_TRACE keeps the newest events per thread") {
+  std::thread([] {
+    for (unsigned i = 0; i < util::trace::ring_capacity; ++i) {
+      util::trace::begin("tests/old");
+      util::trace::end("tests/old");
+    }
+    util::trace::begin("tests/new");
+    util::trace::end("tests/new");
+  }).join();
+
+  const support::temp_file file;
+  REQUIRE(file);
+  const char* path = file.path();
+  REQUIRE(util::trace::flush(path));
+  const std::string json = read_all(path);
+
+  CHECK(occurrences(json, "\"name\":\"tests/new\"") == 2);
+  CHECK(occurrences(json, "\"name\":\"tests/old\"") <= util::trace::ring_capacity - 2);
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * utils.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../support/temp_file.hpp"
+#include "../utils.hpp"
+
+#include "doctest.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <unistd.h>
+
+TEST_CASE("io_error") {
+  util::io_error e = util::io_error::from_errno("Failed to open file.", ENOENT, "/no/such/path");
+  CHECK(e.errnum() == ENOENT);
+  CHECK(std::strcmp(e.path(), "/no/such/path") == 0);
+
+  // Same path, same interned id.
+  util::io_error e2 = util::io_error::from_errno("Failed to open file.", ENOENT, "/no/such/path");
+  CHECK(e.path() == e2.path());
+
+  e.context("first");
+  e.context("second");
+  CHECK(std::strcmp(get_context(e),
+                    "Failed to open file.: No such file or directory (/no/such/path)"
+                    "\n\tfirst\n\tsecond") == 0);
+
+  // Copies share the chain, new context only extends the copy.
+  util::io_error e3 = e;
+  e3.context("third");
+  CHECK(std::strstr(get_context(e3), "\n\tsecond\n\tthird") != nullptr);
+  CHECK(std::strstr(get_context(e), "third") == nullptr);
+
+  CHECK(std::strcmp(get_context(util::io_error::from_context("op")), "op") == 0);
+}
+
+namespace {
+  template<typename Op>
+  auto makes_io_error(int) -> decltype(util::io_error::from_context(std::declval<Op>()), true) {
+    return true;
+  }
+
+  template<typename Op>
+  bool makes_io_error(long) {
+    return false;
+  }
+} // namespace
+
+TEST_CASE("io_error keeps copies of its context and path, not its op") {
+  // The op has to outlive the error: only arrays, not pointers, will do.
+  CHECK(!makes_io_error<const char*>(0));
+  CHECK(!makes_io_error<std::string>(0));
+  CHECK(makes_io_error<const char (&)[3]>(0));
+
+  static const char op[] = "Failed to parse.";
+  std::string msg = "while reading section [net]";
+  std::string path = "/etc/net.conf";
+  util::io_error e = util::io_error::from_errno(op, EINVAL, path.c_str());
+  e.context(msg.c_str());
+  msg.assign(msg.size(), '?');
+  path.assign(path.size(), '?');
+  CHECK(e.what() == op);
+  CHECK(std::strcmp(get_context(e),
+                    "Failed to parse.: Invalid argument (/etc/net.conf)"
+                    "\n\twhile reading section [net]") == 0);
+
+  // Interned by content, not by address.
+  CHECK(util::io_error::from_errno(op, EINVAL, "/etc/net.conf").path() == e.path());
+}
+
+TEST_CASE("open failure") {
+  auto r = util::open("/no/such/dir/conf.ini", util::openmode::in)
+             .context("Failed to load conf.ini");
+  REQUIRE(r.is_err());
+  CHECK(r.err().errnum() == ENOENT);
+  CHECK(std::strcmp(r.err().path(), "/no/such/dir/conf.ini") == 0);
+  CHECK(std::strstr(get_context(r.err()), "\n\tFailed to load conf.ini") != nullptr);
+
+  CHECK(util::open("conf.ini", 0).is_err());
+}
+
+TEST_CASE("fallible allocation") {
+  std::string s;
+  CHECK(util::try_reserve(s, 100).is_ok());
+  CHECK(s.capacity() >= 100);
+  CHECK(&util::try_resize(s, 10).ok() == &s);
+  CHECK(s.size() == 10);
+
+  auto r = util::try_resize(s, s.max_size() + 1);
+  REQUIRE(r.is_err());
+  CHECK(r.err().errnum() == EOVERFLOW);
+  CHECK(s.size() == 10);
+
+  auto big = util::try_make_string(4096);
+  REQUIRE(big.is_ok());
+  CHECK(big.ok().size() == 4096);
+  CHECK(big.ok()[4095] == '\0');
+}
+
+TEST_CASE("map_file") {
+  const support::temp_file file("key=value\n");
+  REQUIRE(file);
+  const char* path = file.path();
+
+  util::map_options options;
+  options.populate   = true;
+  options.access     = util::map_options::advice::sequential;
+  options.huge_pages = true;
+  for (util::map_options o : {util::map_options{}, options}) {
+    auto view = util::map_file(path, o);
+    REQUIRE(view.is_ok());
+    CHECK(std::string(view.ok().begin(), view.ok().end()) == "key=value\n");
+#if __cplusplus >= 201703L
+    CHECK(view.ok().as_string_view() == "key=value\n");
+#endif
+#if __cplusplus >= 202002L && __has_include(<span>)
+    CHECK(view.ok().as_bytes().size() == 10);
+#endif
+  }
+
+  // Moves hand the mapping over, the moved from view is empty.
+  util::mapped_view moved = util::map_file(std::string(path)).ok();
+  util::mapped_view other = std::move(moved);
+  CHECK(moved.empty());
+  CHECK(other.size() == 10);
+  moved = std::move(other);
+  CHECK(moved.data()[0] == 'k');
+
+  REQUIRE(truncate(path, 0) == 0);
+  auto empty = util::map_file(path);
+  REQUIRE(empty.is_ok());
+  CHECK(empty.ok().empty());
+
+  auto missing = util::map_file("/no/such/file");
+  REQUIRE(missing.is_err());
+  CHECK(missing.err().errnum() == ENOENT);
+  CHECK(std::strcmp(missing.err().path(), "/no/such/file") == 0);
+
+  for (const char* other : {"/dev/null", "/tmp"}) {
+    auto r = util::map_file(other);
+    REQUIRE(r.is_err());
+    CHECK(r.err().errnum() == EINVAL);
+    CHECK(std::strcmp(r.err().what(), "Not a regular file.") == 0);
+  }
+
+  // A pipe, through its /proc link.
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  const std::string pipe_path = "/proc/self/fd/" + std::to_string(fds[0]);
+  auto piped = util::map_file(pipe_path);
+  CHECK((piped.is_err() && piped.err().errnum() == EINVAL));
+  close(fds[0]);
+  close(fds[1]);
+}
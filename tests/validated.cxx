@@ -0,0 +1,124 @@
+/*
+ * validated.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "../validated.hpp"
+
+#include "doctest.h"
+
+#include <string>
+
+namespace {
+  struct config_error {
+    const char* key;
+  };
+
+  template<typename T>
+  using ConfigValue = util::Validated<T, config_error, 2>;
+
+  ConfigValue<int> port(int v) {
+    if (v <= 0 || v > 65535) {
+      return util::Err(config_error{"port"});
+    }
+    return util::Ok(v);
+  }
+
+  ConfigValue<std::string> host(std::string v) {
+    if (v.empty()) {
+      return util::Err(config_error{"host"});
+    }
+    return util::Ok(std::move(v));
+  }
+
+  util::Result<int, config_error> threads(int v) {
+    if (v < 1) {
+      return util::Err(config_error{"threads"});
+    }
+    return v;
+  }
+
+  struct config {
+    int port;
+    std::string host;
+    int threads;
+  };
+
+  config make_config(int p, std::string h, int t) {
+    return config{p, std::move(h), t};
+  }
+} // namespace
+
+TEST_CASE("Validated") {
+  auto ok = util::validate(make_config, port(80), host("localhost"), threads(4));
+  REQUIRE(ok.is_valid());
+  CHECK(ok.value().port == 80);
+  CHECK(ok.value().host == "localhost");
+  CHECK(ok.value().threads == 4);
+
+  auto two = util::validate(make_config, port(0), host("localhost"), threads(0));
+  REQUIRE(!two.is_valid());
+  REQUIRE(two.errors().size() == 2);
+  CHECK(!two.errors().spilled());
+  CHECK(std::string(two.errors()[0].key) == "port");
+  CHECK(std::string(two.errors()[1].key) == "threads");
+
+  // Past N errors spill to the heap, nothing is dropped.
+  auto three = util::validate(make_config, port(-1), host(""), threads(0));
+  REQUIRE(three.errors().size() == 3);
+  CHECK(three.errors().spilled());
+  CHECK(std::string(three.errors()[2].key) == "threads");
+
+  auto res = std::move(three).to_result();
+  REQUIRE(res.is_err());
+  CHECK(res.err().size() == 3);
+
+  auto first = util::validate(make_config, port(1), host(""), threads(0))
+                 .to_first_error();
+  REQUIRE(first.is_err());
+  CHECK(std::string(first.err().key) == "host");
+
+  ConfigValue<int> from_result{threads(2)};
+  CHECK(from_result.value() == 2);
+
+  // Arguments with a different inline capacity than the first one.
+  util::Validated<std::string, config_error, 8> wide = util::Err(config_error{"host"});
+  auto mixed = util::validate(make_config, port(0), std::move(wide), threads(0));
+  REQUIRE(mixed.errors().size() == 3);
+  CHECK(std::string(mixed.errors()[1].key) == "host");
+}
+
+TEST_CASE("inline_vector") {
+  util::error_list<std::string, 2> v{"a", "b"};
+  CHECK(!v.spilled());
+  v.push_back("c");
+  CHECK(v.spilled());
+
+  auto copy = v;
+  auto moved = std::move(v);
+  CHECK(v.empty());
+  CHECK(copy.size() == 3);
+  CHECK(moved[2] == "c");
+
+  util::error_list<std::string, 2> small{"x"};
+  moved = std::move(small);
+  CHECK(moved.size() == 1);
+  CHECK(!moved.spilled());
+}
+
+TEST_CASE("inline_vector grows past elements of its own") {
+  // Full, so each push_back of an element moves the storage it refers to.
+  util::error_list<std::string, 2> v{"a long enough string to be on the heap", "b"};
+  v.push_back(v[0]);
+  REQUIRE(v.size() == 3);
+  CHECK(v[2] == v[0]);
+
+  v.push_back(v[1]);
+  v.append(v);
+  REQUIRE(v.size() == 8);
+  CHECK(v[3] == "b");
+  CHECK(v[4] == v[0]);
+  CHECK(v[7] == "b");
+}
@@ -0,0 +1,107 @@
+/*
+ * thread_slot.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef THREAD_SLOT_HPP_Q4HT7M1B
+#define THREAD_SLOT_HPP_Q4HT7M1B
+
+// Internal to the .cxx files: the per thread tables and rings of
+// result_stats, timing, trace and error_log.
+
+#include <atomic>
+#include <new>
+
+namespace util {
+  namespace details {
+    /**
+     *  A T per thread, written by that thread and read by any other through
+     *  for_each(). Ts are never freed: when a thread exits its T is released
+     *  as it is, and the next thread to call get() takes it over instead of
+     *  allocating one, so that their count stays at the most threads ever
+     *  alive at once.
+     *
+     *  Each distinct T is its own set; tag types keep two users of the same
+     *  T apart.
+     */
+    template<typename T, typename Tag = T>
+    class thread_slot {
+    public:
+      // This thread's T, claimed on first use. nullptr while the thread is
+      // exiting, or if there was no T to take over and allocating one failed.
+      static T* get() noexcept {
+        if (mine_ == nullptr && !exited_) {
+          mine_ = claim();
+          releaser_.armed = true;
+        }
+        return mine_ != nullptr ? &mine_->value : nullptr;
+      }
+
+      // Calls @p fn(T&) on every T ever made, owned or not, newest first.
+      template<typename F>
+      static void for_each(F&& fn) {
+        for (node* n = head_.load(std::memory_order_acquire); n; n = n->next) {
+          fn(n->value);
+        }
+      }
+
+    private:
+      struct node {
+        T value;
+        std::atomic<bool> owned{true};
+        node* next = nullptr;
+      };
+
+      struct releaser {
+        bool armed = false;
+        ~releaser() {
+          exited_ = true;
+          if (mine_ != nullptr) {
+            mine_->owned.store(false, std::memory_order_release);
+            mine_ = nullptr;
+          }
+        }
+      };
+
+      static node* claim() noexcept {
+        for (node* n = head_.load(std::memory_order_acquire); n; n = n->next) {
+          bool owned = false;
+          if (n->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+            return n;
+          }
+        }
+        node* n = new (std::nothrow) node;
+        if (n == nullptr) {
+          return nullptr;
+        }
+        n->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        return n;
+      }
+
+      static std::atomic<node*> head_;
+      static thread_local node* mine_;
+      static thread_local bool exited_;
+      // Only odr-used, and so constructed, once get() has run on a thread.
+      static thread_local releaser releaser_;
+    };
+
+    template<typename T, typename Tag>
+    std::atomic<typename thread_slot<T, Tag>::node*> thread_slot<T, Tag>::head_{nullptr};
+
+    template<typename T, typename Tag>
+    thread_local typename thread_slot<T, Tag>::node* thread_slot<T, Tag>::mine_ = nullptr;
+
+    template<typename T, typename Tag>
+    thread_local bool thread_slot<T, Tag>::exited_ = false;
+
+    template<typename T, typename Tag>
+    thread_local typename thread_slot<T, Tag>::releaser thread_slot<T, Tag>::releaser_;
+  } // namespace details
+} // namespace util
+
+#endif /* end of include guard: THREAD_SLOT_HPP_Q4HT7M1B */
@@ -0,0 +1,232 @@
+/*
+ * timing.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "timing.hpp"
+#include "thread_slot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <new>
+#include <utility>
+
+#include <time.h>
+
+namespace util {
+  namespace timing {
+    namespace details {
+      struct histogram_access {
+        static void add(histogram& h, unsigned bucket, std::uint64_t n) {
+          h.counts_[bucket] += n;
+        }
+
+        static void add_totals(histogram& h, std::uint64_t count, std::uint64_t sum,
+                               std::uint64_t max) {
+          h.count_ += count;
+          h.sum_ += sum;
+          h.max_ = std::max(h.max_, max);
+        }
+      };
+    } // namespace details
+  } // namespace timing
+} // namespace util
+
+namespace{
+  using util::timing::details::histogram_access;
+  using util::timing::histogram;
+  using util::timing::max_sites;
+
+  // histogram as filled by its one owning thread and read by any other.
+  struct thread_histogram {
+    // The total count is the sum of these, taken when read.
+    std::atomic<std::uint64_t> counts[histogram::bucket_count];
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> max;
+
+    void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) {
+      // Single writer: no need for a locked add.
+      a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void record(std::uint64_t ticks) {
+      bump(counts[histogram::bucket_of(ticks)], 1);
+      bump(sum, ticks);
+      if(ticks > max.load(std::memory_order_relaxed)){
+        max.store(ticks, std::memory_order_relaxed);
+      }
+    }
+
+    // Racing with the owner can tear a sample across fields, never a count.
+    void add_to(histogram& h) const {
+      std::uint64_t total = 0;
+      for(unsigned b = 0; b < histogram::bucket_count; ++b){
+        const std::uint64_t n = counts[b].load(std::memory_order_relaxed);
+        histogram_access::add(h, b, n);
+        total += n;
+      }
+      histogram_access::add_totals(h, total, sum.load(std::memory_order_relaxed),
+                                   max.load(std::memory_order_relaxed));
+    }
+  };
+
+  struct site_pair {
+    thread_histogram ok;
+    thread_histogram err;
+  };
+
+  // Per thread (see thread_slot), site pairs allocated on first use.
+  struct block {
+    std::atomic<site_pair*> sites[max_sites];
+
+    block() {
+      for(auto& s : sites){
+        s.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  using blocks = util::details::thread_slot<block>;
+
+  const char* site_names[max_sites];
+  std::atomic<std::uint32_t> next_site_id{0};
+
+  site_pair* get_pair(std::uint32_t id) noexcept {
+    block* b = blocks::get();
+    if(b == nullptr){
+      return nullptr;
+    }
+    site_pair* p = b->sites[id].load(std::memory_order_relaxed);
+    if(p == nullptr){
+      // Value-initialized: all counters start at zero.
+      p = new(std::nothrow) site_pair();
+      if(p != nullptr){
+        b->sites[id].store(p, std::memory_order_release);
+      }
+    }
+    return p;
+  }
+
+  std::uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+  }
+
+  double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+    const std::uint64_t ns0    = monotonic_ns();
+    const std::uint64_t ticks0 = util::timing::now();
+    const timespec pause{0, 10 * 1000 * 1000};
+    nanosleep(&pause, nullptr);
+    const std::uint64_t ns1    = monotonic_ns();
+    const std::uint64_t ticks1 = util::timing::now();
+    if(ticks1 <= ticks0){
+      return 1.0;
+    }
+    return static_cast<double>(ns1 - ns0) / static_cast<double>(ticks1 - ticks0);
+#else
+    return 1.0;
+#endif
+  }
+}
+
+namespace util {
+  namespace timing {
+    double ns_per_tick() noexcept {
+      static const double ratio = calibrate();
+      return ratio;
+    }
+
+    site::site(const char* name) noexcept
+      : name_(name)
+      , id_(next_site_id.fetch_add(1, std::memory_order_relaxed)) {
+      if(id_ < max_sites){
+        site_names[id_] = name;
+      }
+    }
+
+    void histogram::record(std::uint64_t ticks, std::uint64_t n) noexcept {
+      counts_[bucket_of(ticks)] += n;
+      count_ += n;
+      sum_ += ticks * n;
+      max_ = std::max(max_, ticks);
+    }
+
+    void histogram::merge(const histogram& other) noexcept {
+      for(unsigned b = 0; b < bucket_count; ++b){
+        counts_[b] += other.counts_[b];
+      }
+      count_ += other.count_;
+      sum_ += other.sum_;
+      max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t histogram::quantile(double q) const noexcept {
+      if(count_ == 0){
+        return 0;
+      }
+      const double clamped = std::min(std::max(q, 0.0), 1.0);
+      const std::uint64_t rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(count_))));
+      std::uint64_t seen = 0;
+      for(unsigned b = 0; b < bucket_count; ++b){
+        seen += counts_[b];
+        if(seen >= rank){
+          return std::min(bucket_upper(b), max_);
+        }
+      }
+      return max_;
+    }
+
+    std::vector<site_histograms> snapshot() {
+      const std::uint32_t sites = std::min(next_site_id.load(std::memory_order_relaxed), max_sites);
+      std::vector<site_histograms> result;
+      for(std::uint32_t id = 0; id < sites; ++id){
+        site_histograms merged{site_names[id], {}, {}};
+        blocks::for_each([&](const block& b) {
+          if(const site_pair* p = b.sites[id].load(std::memory_order_acquire)){
+            p->ok.add_to(merged.ok);
+            p->err.add_to(merged.err);
+          }
+        });
+        if(merged.ok.count() + merged.err.count() != 0){
+          result.push_back(std::move(merged));
+        }
+      }
+      return result;
+    }
+
+    void dump(std::FILE* out) {
+      const double scale = ns_per_tick();
+      std::fprintf(out, "site\toutcome\tcount\tmean_ns\tp50_ns\tp90_ns\tp99_ns\tp999_ns\tmax_ns\n");
+      for(const site_histograms& s : snapshot()){
+        const std::pair<const char*, const histogram*> outcomes[] = {{"ok", &s.ok}, {"err", &s.err}};
+        for(const auto& o : outcomes){
+          const histogram& h = *o.second;
+          if(h.count() == 0){
+            continue;
+          }
+          std::fprintf(out, "%s\t%s\t%llu\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\n", s.name, o.first,
+                       static_cast<unsigned long long>(h.count()), h.mean() * scale,
+                       h.quantile(0.5) * scale, h.quantile(0.9) * scale,
+                       h.quantile(0.99) * scale, h.quantile(0.999) * scale, h.max() * scale);
+        }
+      }
+    }
+
+    namespace details {
+      void record(const site& s, std::uint64_t ticks, bool ok) noexcept {
+        if(s.id() >= max_sites){
+          return;
+        }
+        if(site_pair* p = get_pair(s.id())){
+          (ok ? p->ok : p->err).record(ticks);
+        }
+      }
+    } // namespace details
+  } // namespace timing
+} // namespace util
@@ -0,0 +1,188 @@
+/*
+ * timing.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef TIMING_HPP_8PZ4XN2C
+#define TIMING_HPP_8PZ4XN2C
+
+// Latency histograms for Result returning calls, kept apart for the ok and
+// the err outcome:
+//
+//   static util::timing::site open_site{"open"};
+//   auto file = util::timed(open_site, [&] { return util::open(path, mode); });
+//
+// Each thread records into its own histograms without locking; snapshot()
+// and dump() merge them.
+
+#include "result.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+namespace util {
+  namespace timing {
+    // Ticks of the cheapest clock there is: the TSC on x86 (assumed
+    // invariant), CLOCK_MONOTONIC nanoseconds elsewhere.
+    inline std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+#endif
+    }
+
+    // Calibrated against CLOCK_MONOTONIC on first use.
+    double ns_per_tick() noexcept;
+
+    constexpr std::uint32_t max_sites = 256;
+
+    namespace details {
+      struct histogram_access;
+    } // namespace details
+
+    /**
+     *  A name to record timings under. Meant to have static storage
+     *  duration; sites past the first max_sites aren't recorded.
+     */
+    class site {
+    public:
+      explicit site(const char* name) noexcept;
+
+      site(const site&) = delete;
+      site& operator=(const site&) = delete;
+
+      const char* name() const noexcept {
+        return name_;
+      }
+
+      std::uint32_t id() const noexcept {
+        return id_;
+      }
+
+    private:
+      const char* name_;
+      std::uint32_t id_;
+    };
+
+    /**
+     *  Log-linear histogram of tick counts: exact below 32, then 16 linear
+     *  buckets per power of two, so a bucket is never wider than 1/16 of its
+     *  values. Values past 2^41 share the last bucket.
+     */
+    class histogram {
+    public:
+      static constexpr unsigned sub_buckets  = 16;
+      static constexpr unsigned max_exponent = 40;
+      static constexpr unsigned bucket_count = (max_exponent - 2) * sub_buckets;
+
+      static unsigned bucket_of(std::uint64_t ticks) noexcept {
+        if (ticks < sub_buckets) {
+          return static_cast<unsigned>(ticks);
+        }
+        const unsigned e = 63 - static_cast<unsigned>(__builtin_clzll(ticks));
+        if (e > max_exponent) {
+          return bucket_count - 1;
+        }
+        return (e - 3) * sub_buckets +
+               static_cast<unsigned>((ticks >> (e - 4)) & (sub_buckets - 1));
+      }
+
+      static std::uint64_t bucket_lower(unsigned b) noexcept {
+        if (b < 2 * sub_buckets) {
+          return b;
+        }
+        const unsigned e = b / sub_buckets + 3;
+        return static_cast<std::uint64_t>(sub_buckets + b % sub_buckets)
+               << (e - 4);
+      }
+
+      static std::uint64_t bucket_upper(unsigned b) noexcept {
+        if (b < 2 * sub_buckets) {
+          return b;
+        }
+        const unsigned e = b / sub_buckets + 3;
+        return bucket_lower(b) + (std::uint64_t{1} << (e - 4)) - 1;
+      }
+
+      void record(std::uint64_t ticks, std::uint64_t n = 1) noexcept;
+      void merge(const histogram& other) noexcept;
+
+      std::uint64_t count() const noexcept {
+        return count_;
+      }
+
+      std::uint64_t sum() const noexcept {
+        return sum_;
+      }
+
+      std::uint64_t max() const noexcept {
+        return max_;
+      }
+
+      std::uint64_t bucket(unsigned b) const noexcept {
+        return counts_[b];
+      }
+
+      double mean() const noexcept {
+        return count_ ? static_cast<double>(sum_) / count_ : 0.0;
+      }
+
+      // Upper bound of the bucket holding quantile @p q in [0, 1], at most max().
+      std::uint64_t quantile(double q) const noexcept;
+
+    private:
+      // Fills these in from the per-thread counters.
+      friend struct details::histogram_access;
+
+      std::uint64_t counts_[bucket_count] = {};
+      std::uint64_t count_ = 0;
+      std::uint64_t sum_   = 0;
+      std::uint64_t max_   = 0;
+    };
+
+    struct site_histograms {
+      const char* name;
+      histogram ok;
+      histogram err;
+    };
+
+    // Every site with at least one sample, merged over all threads.
+    std::vector<site_histograms> snapshot();
+
+    // One line per site and outcome: count, mean and percentiles in ns.
+    void dump(std::FILE* out);
+
+    namespace details {
+      void record(const site& s, std::uint64_t ticks, bool ok) noexcept;
+    } // namespace details
+  } // namespace timing
+
+  /**
+   *  Calls @p fn, which returns a Result, and records how long it took
+   *  under @p s, split by whether it returned ok or err.
+   */
+  template<typename F>
+  std::decay_t<details::result_of_t<F()>> timed(timing::site& s, F&& fn) {
+    static_assert(details::is_result<std::decay_t<details::result_of_t<F()>>>,
+                  "timed() needs a function returning a Result.");
+    const std::uint64_t start = timing::now();
+    std::decay_t<details::result_of_t<F()>> res = fn();
+    timing::details::record(s, timing::now() - start, res.is_ok());
+    return res;
+  }
+} // namespace util
+
+#endif /* end of include guard: TIMING_HPP_8PZ4XN2C */
@@ -0,0 +1,49 @@
+/*
+ * measure.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// measure <command> [args...]
+//
+// Runs the command and prints "<wall seconds> <peak rss KiB>" to stderr,
+// exiting with the command's status. A stand-in for GNU time -f "%e %M".
+
+#include <chrono>
+#include <cstdio>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <command> [args...]\n", argv[0]);
+    return 2;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid  = fork();
+  if (pid == -1) {
+    std::perror("fork");
+    return 2;
+  }
+  if (pid == 0) {
+    execvp(argv[1], argv + 1);
+    std::perror("execvp");
+    _exit(127);
+  }
+
+  int status = 0;
+  struct rusage usage {};
+  if (wait4(pid, &status, 0, &usage) == -1) {
+    std::perror("wait4");
+    return 2;
+  }
+  const std::chrono::duration<double> wall =
+    std::chrono::steady_clock::now() - start;
+
+  std::fprintf(stderr, "%.3f %ld\n", wall.count(), usage.ru_maxrss);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
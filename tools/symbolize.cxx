@@ -0,0 +1,54 @@
+/*
+ * symbolize.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+// symbolize <record>
+//
+// Prints the report backward::SignalHandling would have printed for a crash
+// record it wrote in raw mode (SignalHandling::write_raw_records_to),
+// resolving the frames against the objects the crashed process had loaded.
+// Run it on the machine that crashed, or one with the same binaries.
+
+#define BACKWARD_HAS_DW 1
+#include "../contrib/backward.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <record>\n", argv[0]);
+    return 2;
+  }
+
+  backward::RawCrashRecord record;
+  if (!record.load(argv[1])) {
+    std::fprintf(stderr, "%s: not a crash record, or truncated.\n", argv[1]);
+    return 1;
+  }
+
+  backward::TraceResolver resolver;
+  if (!resolver.load_objects(record.objects.begin(), record.objects.end())) {
+    std::fprintf(stderr, "%s: couldn't load the recorded objects.\n", argv[1]);
+  }
+
+  // Outermost first, the same as Printer::print(StackTrace&).
+  std::vector<backward::ResolvedTrace> traces;
+  for (std::size_t i = record.frames.size(); i > 0; --i) {
+    traces.push_back(
+      resolver.resolve(backward::ResolvedTrace(backward::Trace(record.frames[i - 1], i - 1))));
+  }
+
+  backward::Printer printer;
+  printer.address = true;
+  printer.print(traces.begin(), traces.end(), stdout, static_cast<std::size_t>(record.header.tid));
+
+  const backward::details::raw_crash_header& h = record.header;
+  std::printf("Signal %d (%s), code %d, address %p, in process %d\n", h.signo,
+              strsignal(h.signo), h.code,
+              reinterpret_cast<void*>(static_cast<std::uintptr_t>(h.fault_addr)), h.pid);
+}
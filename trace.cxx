@@ -0,0 +1,205 @@
+/*
+ * trace.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#include "trace.hpp"
+#include "timing.hpp"
+#include "thread_slot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace{
+  using util::trace::ring_capacity;
+
+  static_assert((ring_capacity & (ring_capacity - 1)) == 0, "ring_capacity must be a power of two.");
+
+  enum kind : std::uint32_t { span_begin, span_end, span_end_ok, span_end_err, err_created };
+
+  // info packs kind (8 bits), line (24 bits) and tid (32 bits).
+  struct event {
+    std::uint64_t ts;
+    const char* name;
+    std::uint64_t info;
+  };
+
+  struct event_slot {
+    std::atomic<std::uint64_t> ts;
+    std::atomic<const char*> name;
+    std::atomic<std::uint64_t> info;
+  };
+
+  // One per thread (see thread_slot), written only by its owner. head
+  // counts every event ever pushed; the slots hold the last ring_capacity
+  // of them.
+  struct ring {
+    event_slot slots[ring_capacity];
+    std::atomic<std::uint64_t> head{0};
+  };
+
+  using rings = util::details::thread_slot<ring>;
+
+  thread_local std::uint32_t this_tid = 0;
+
+  void push(kind k, const char* name, unsigned line) noexcept {
+    ring* r = rings::get();
+    if(r == nullptr){
+      return;
+    }
+    if(this_tid == 0){
+      this_tid = static_cast<std::uint32_t>(::syscall(SYS_gettid));
+    }
+    const std::uint64_t head = r->head.load(std::memory_order_relaxed);
+    // Pairs with the fence in collect(): a reader that sees any of the
+    // stores below also sees head >= this one, so it can tell the slot
+    // was being overwritten.
+    std::atomic_thread_fence(std::memory_order_release);
+    event_slot& slot = r->slots[head & (ring_capacity - 1)];
+    slot.ts.store(util::timing::now(), std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.info.store(k | (static_cast<std::uint64_t>(line & 0xffffff) << 8) |
+                      (static_cast<std::uint64_t>(this_tid) << 32),
+                    std::memory_order_relaxed);
+    r->head.store(head + 1, std::memory_order_release);
+  }
+
+  // Copies out a ring's events, dropping any its owner overwrote meanwhile.
+  void collect(const ring& r, std::vector<event>& out) {
+    const std::uint64_t head  = r.head.load(std::memory_order_acquire);
+    const std::uint64_t first = head > ring_capacity ? head - ring_capacity : 0;
+    const std::size_t start   = out.size();
+    for(std::uint64_t i = first; i < head; ++i){
+      const event_slot& slot = r.slots[i & (ring_capacity - 1)];
+      out.push_back({slot.ts.load(std::memory_order_relaxed),
+                     slot.name.load(std::memory_order_relaxed),
+                     slot.info.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t now_head = r.head.load(std::memory_order_relaxed);
+    // Event i is intact while event i + ring_capacity hasn't been started.
+    if(now_head >= first + ring_capacity){
+      const std::uint64_t lost = now_head - ring_capacity + 1 - first;
+      out.erase(out.begin() + start,
+                out.begin() + start + static_cast<std::ptrdiff_t>(std::min<std::uint64_t>(lost, head - first)));
+    }
+  }
+
+  void put_json_string(std::FILE* out, const char* s) {
+    std::fputc('"', out);
+    for(; *s; ++s){
+      const unsigned char c = static_cast<unsigned char>(*s);
+      if(c == '"' || c == '\\'){
+        std::fputc('\\', out);
+        std::fputc(c, out);
+      } else if(c < 0x20){
+        std::fprintf(out, "\\u%04x", c);
+      } else {
+        std::fputc(c, out);
+      }
+    }
+    std::fputc('"', out);
+  }
+
+  char exit_path[4096];
+
+  void flush_exit_path() {
+    util::trace::flush(exit_path);
+  }
+
+  struct flush_from_env {
+    flush_from_env() {
+      if(const char* path = std::getenv("RESULT_TRACE_FILE")){
+        util::trace::flush_at_exit(path);
+      }
+    }
+  } flush_from_env_;
+}
+
+namespace util {
+  namespace trace {
+    void begin(const char* name) noexcept {
+      push(span_begin, name, 0);
+    }
+
+    void end(const char* name) noexcept {
+      push(span_end, name, 0);
+    }
+
+    void end(const char* name, bool ok) noexcept {
+      push(ok ? span_end_ok : span_end_err, name, 0);
+    }
+
+    void err_created(const char* file, unsigned line) noexcept {
+      push(kind::err_created, file, line);
+    }
+
+    bool flush(const char* path) {
+      std::vector<event> events;
+      rings::for_each([&](const ring& r) { collect(r, events); });
+      std::uint64_t base = ~std::uint64_t{0};
+      for(const event& e : events){
+        base = std::min(base, e.ts);
+      }
+
+      std::FILE* out = std::fopen(path, "w");
+      if(out == nullptr){
+        return false;
+      }
+      const double us_per_tick = timing::ns_per_tick() / 1000.0;
+      const long pid = static_cast<long>(::getpid());
+      std::fputs("{\"traceEvents\":[", out);
+      bool first = true;
+      for(const event& e : events){
+        const kind k = static_cast<kind>(e.info & 0xff);
+        const unsigned line = static_cast<unsigned>((e.info >> 8) & 0xffffff);
+        const unsigned tid = static_cast<unsigned>(e.info >> 32);
+        std::fputs(first ? "\n" : ",\n", out);
+        first = false;
+
+        std::fputs("{\"name\":", out);
+        put_json_string(out, k == kind::err_created ? "Err" : e.name);
+        std::fprintf(out, ",\"cat\":\"result\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%u,",
+                     static_cast<double>(e.ts - base) * us_per_tick, pid, tid);
+        switch(k){
+          case span_begin:
+            std::fputs("\"ph\":\"B\"}", out);
+            break;
+          case span_end:
+            std::fputs("\"ph\":\"E\"}", out);
+            break;
+          case span_end_ok:
+          case span_end_err:
+            std::fprintf(out, "\"ph\":\"E\",\"args\":{\"outcome\":\"%s\"}}",
+                         k == span_end_ok ? "ok" : "err");
+            break;
+          case kind::err_created:
+            std::fputs("\"ph\":\"i\",\"s\":\"t\",\"args\":{\"file\":", out);
+            put_json_string(out, e.name);
+            std::fprintf(out, ",\"line\":%u}}", line);
+            break;
+        }
+      }
+      std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", out);
+      const bool ok = !std::ferror(out);
+      return std::fclose(out) == 0 && ok;
+    }
+
+    void flush_at_exit(const char* path) {
+      const bool registered = exit_path[0] != '\0';
+      std::strncpy(exit_path, path, sizeof(exit_path) - 1);
+      if(!registered){
+        std::atexit(flush_exit_path);
+      }
+    }
+  } // namespace trace
+} // namespace util
@@ -0,0 +1,75 @@
+/*
+ * trace.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef TRACE_HPP_F6JW1R9B
+#define TRACE_HPP_F6JW1R9B
+
+// Timeline of Result spans and Err creations, written out as a Chrome trace
+// (load it in about:tracing or ui.perfetto.dev):
+//
+//   auto cfg = util::traced("load_config", [&] { return load_config(path); });
+//
+// Built with RESULT_TRACE=1, result.hpp also adds an instant event for every
+// Err, and util::open/util::as_string trace themselves.
+//
+// Events go into a fixed-size ring per thread, overwriting the oldest, so
+// the trace always holds the most recent history. flush() writes all rings;
+// flush_at_exit(), or RESULT_TRACE_FILE=<path> in the environment, does so
+// when the process exits.
+//
+// Names must outlive the trace, i.e. be string literals.
+
+#include <type_traits>
+#include <utility>
+
+namespace util {
+  namespace trace {
+    // Events kept per thread.
+    constexpr unsigned ring_capacity = 1 << 14;
+
+    void begin(const char* name) noexcept;
+    void end(const char* name) noexcept;
+    void end(const char* name, bool ok) noexcept;
+    void err_created(const char* file, unsigned line) noexcept;
+
+    bool flush(const char* path);
+    void flush_at_exit(const char* path);
+
+    class scope {
+    public:
+      explicit scope(const char* name) noexcept
+        : name_(name) {
+        begin(name);
+      }
+
+      scope(const scope&) = delete;
+      scope& operator=(const scope&) = delete;
+
+      ~scope() {
+        end(name_);
+      }
+
+    private:
+      const char* name_;
+    };
+  } // namespace trace
+
+  /**
+   *  Calls @p fn, which returns a Result, inside a span named @p name whose
+   *  end event records whether it returned ok or err.
+   */
+  template<typename F>
+  std::decay_t<decltype(std::declval<F>()())> traced(const char* name,
+                                                      F&& fn) {
+    trace::begin(name);
+    std::decay_t<decltype(std::declval<F>()())> res = std::forward<F>(fn)();
+    trace::end(name, res.is_ok());
+    return res;
+  }
+} // namespace util
+
+#endif /* end of include guard: TRACE_HPP_F6JW1R9B */
@@ -7,23 +7,51 @@
 
 #include "utils.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#if RESULT_TRACE
+#include "trace.hpp"
+#define TRACE_SCOPE_(name) util::trace::scope trace_scope_{name}
+#else
+#define TRACE_SCOPE_(name) static_cast<void>(0)
+#endif
+
+// Fails like the real call would with EIO when fault.hpp says so.
+#if RESULT_FAULTS
+#include "fault.hpp"
+#define FAULT_(where, ...)                                                     \
+  do {                                                                         \
+    if(util::fault::should_fail(util::fault::point::where)){                   \
+      return io_error::from_errno(__VA_ARGS__);                                \
+    }                                                                          \
+  } while(0)
+#else
+#define FAULT_(where, ...) static_cast<void>(0)
+#endif
+
 #ifdef _WIN32
 #error TODO
 #else
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 namespace util {
   namespace {
     IOError<off_t> file_size(const fstream_ptr& fPtr) {
+      FAULT_(file_size, "Unable to fstat fd.", EIO);
       const int fd = fileno(fPtr.get());
       if(fd == -1){
-        return io_error{"Unable to convert the file pointer into a fd number."};
+        return io_error::from_errno("Unable to convert the file pointer into a fd number.", errno);
       }
       struct stat stbuf;
       // if((fstat(fd, &stbuf) != 0) || (!S_ISREG(stbuf.st_mode))){
       if((fstat(fd, &stbuf) != 0)){
-        return io_error{"Unable to fstat fd."};
+        return io_error::from_errno("Unable to fstat fd.", errno);
       }
 
 
@@ -35,6 +63,138 @@ namespace util {
 #endif
 
 namespace{
+  // Fixed size, insert-only intern table. Ids are slot index + 1 so that 0
+  // can mean "none". Lookups and inserts are lock-free and never allocate:
+  // a key is looked for in at most max_probes slots, and when they're all
+  // taken it gets id 0 and is dropped from the rendered message.
+  //
+  // Slot::state: 0 = empty, 1 = being written, 2 = published, 3 = dead
+  // (init failed, skipped by every probe). A slot being written is skipped
+  // too rather than waited for, so two threads inserting the same key at
+  // once may each get a slot of their own.
+  template<typename Slot, std::size_t Capacity>
+  struct intern_table {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+    static_assert(Capacity < UINT16_MAX, "ids must fit in an uint16_t.");
+
+    static constexpr std::size_t max_probes = 64;
+
+    Slot slots[Capacity];
+
+    template<typename Eq, typename Init>
+    uint16_t find_or_insert(std::size_t hash, Eq&& eq, Init&& init) {
+      for(std::size_t i = 0; i < max_probes; ++i){
+        Slot& slot = slots[(hash + i) & (Capacity - 1)];
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        if(state == 0){
+          if(slot.state.compare_exchange_strong(state, 1, std::memory_order_acquire)){
+            if(!init(slot)){
+              slot.state.store(3, std::memory_order_release);
+              return 0;
+            }
+            slot.state.store(2, std::memory_order_release);
+            return static_cast<uint16_t>(&slot - slots + 1);
+          }
+        }
+        if(state == 2 && eq(slot)){
+          return static_cast<uint16_t>(&slot - slots + 1);
+        }
+      }
+      return 0;
+    }
+
+    const Slot* get(uint16_t id) const {
+      if(id == 0 || id > Capacity){
+        return nullptr;
+      }
+      const Slot& slot = slots[id - 1];
+      return slot.state.load(std::memory_order_acquire) == 2 ? &slot : nullptr;
+    }
+  };
+
+  std::size_t hash_str(const char* s) {
+    // FNV-1a
+    std::size_t h = 14695981039346656037ull;
+    for(; *s; ++s){
+      h ^= static_cast<unsigned char>(*s);
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  struct str_slot {
+    std::atomic<uint32_t> state;
+    const char* str;
+  };
+
+  // Strings interned by content: copied into the arena, bump allocated and
+  // never freed, so callers' strings only have to live through the call.
+  struct string_pool {
+    intern_table<str_slot, 4096> table;
+    char arena[1 << 16];
+    std::atomic<std::size_t> used{0};
+
+    uint16_t intern(const char* s) {
+      return table.find_or_insert(
+        hash_str(s),
+        [&](const str_slot& slot) { return std::strcmp(slot.str, s) == 0; },
+        [&](str_slot& slot) {
+          const std::size_t len = std::strlen(s) + 1;
+          const std::size_t off = used.fetch_add(len, std::memory_order_relaxed);
+          if(off + len > sizeof(arena)){
+            return false;
+          }
+          std::memcpy(arena + off, s, len);
+          slot.str = arena + off;
+          return true;
+        });
+    }
+
+    const char* get(uint16_t id) const {
+      const str_slot* slot = table.get(id);
+      return slot ? slot->str : nullptr;
+    }
+  };
+
+  string_pool path_pool;
+  // Context messages, apart so that they can't crowd out paths.
+  string_pool context_pool;
+
+  struct ctx_slot {
+    std::atomic<uint32_t> state;
+    uint16_t msg;
+    uint16_t parent;
+  };
+
+  intern_table<ctx_slot, 4096> ctx_table;
+
+  uint16_t intern_context(uint16_t parent, const char* msg) {
+    const uint16_t msg_id = context_pool.intern(msg);
+    if(msg_id == 0){
+      return 0;
+    }
+    // Fibonacci hashing, the low bits of msg_id alone would cluster.
+    const std::size_t hash =
+      ((static_cast<std::size_t>(msg_id) << 16 | parent) * 0x9e3779b97f4a7c15ull) >> 20;
+    return ctx_table.find_or_insert(
+      hash,
+      [&](const ctx_slot& slot) { return slot.msg == msg_id && slot.parent == parent; },
+      [&](ctx_slot& slot) {
+        slot.msg    = msg_id;
+        slot.parent = parent;
+        return true;
+      });
+  }
+
+  // strerror_r is either the XSI (int) or the GNU (char*) flavor.
+  inline const char* strerror_result(int, const char* buf) {
+    return buf;
+  }
+
+  inline const char* strerror_result(const char* ret, const char*) {
+    return ret;
+  }
+
   void fstream_ptr_dtor(std::FILE* fPtr){
     if(fPtr){
       std::fclose(fPtr);
@@ -81,25 +241,88 @@ namespace util {
   }
 
   void io_error::context(const char* msg) {
-    if(!buf.empty()){
-      buf += "\n\t";
+    if(msg == nullptr){
+      return;
+    }
+    // If the table is full keep the chain we already have.
+    const uint16_t id = intern_context(ctx_id_, msg);
+    if(id != 0){
+      ctx_id_ = id;
     }
-    buf += msg;
   }
 
-  io_error io_error::from_context(const char* msg){
-    return {};
+  uint16_t io_error::intern_path(const char* path){
+    return path ? path_pool.intern(path) : 0;
+  }
+
+  const char* io_error::path() const noexcept {
+    return path_pool.get(path_id_);
+  }
+
+  const char* get_context(const io_error& ioe){
+    thread_local char buf[1024];
+    std::size_t len = 0;
+    const auto append = [&](const char* str) {
+      const int n = std::snprintf(buf + len, sizeof(buf) - len, "%s", str);
+      if(n > 0){
+        len = std::min(len + static_cast<std::size_t>(n), sizeof(buf) - 1);
+      }
+    };
+
+    append(ioe.what());
+    if(ioe.errnum_ != 0){
+      char errbuf[128];
+      append(": ");
+      append(strerror_result(strerror_r(ioe.errnum_, errbuf, sizeof(errbuf)), errbuf));
+    }
+    if(const char* p = ioe.path()){
+      append(" (");
+      append(p);
+      append(")");
+    }
+
+    // The chain is linked newest first, print it oldest first.
+    const char* chain[64];
+    std::size_t depth = 0;
+    for(const ctx_slot* slot = ctx_table.get(ioe.ctx_id_); slot && depth < 64;
+        slot = ctx_table.get(slot->parent)){
+      chain[depth++] = context_pool.get(slot->msg);
+    }
+    while(depth > 0){
+      append("\n\t");
+      append(chain[--depth]);
+    }
+    return buf;
+  }
+
+  IOError<std::string> try_make_string(std::size_t size){
+    std::string str;
+    // Not Try_: it would hand back a copy of the string.
+    auto resized = try_resize(str, size);
+    if(resized.is_err()){
+      return std::move(resized).err();
+    }
+    return str;
+  }
+
+  IOError<buffer> try_make_buffer(std::size_t size){
+    std::unique_ptr<char[]> data(new (std::nothrow) char[size ? size : 1]);
+    if(data == nullptr){
+      return io_error::from_errno("Out of memory.", ENOMEM);
+    }
+    return buffer(std::move(data), size);
   }
 
   IOError<fstream_ptr> open(const char* path, openmode openm){
+    TRACE_SCOPE_("util::open");
+    FAULT_(open, "Failed to open file.", EIO, path);
     const char* mode = openm.to_modestring();
     if(mode == nullptr){
       return io_error::from_context("Invalid open mode.");
     }
     std::FILE* fPtr = std::fopen(path, mode);
     if(fPtr == nullptr){
-      //TODO: errno string
-      return io_error::from_context("Failed to open file.");
+      return io_error::from_errno("Failed to open file.", errno, path);
     }
 
     return fstream_ptr(fPtr, fstream_ptr_dtor);
@@ -110,15 +333,105 @@ namespace util {
   }
 
   IOError<std::string> as_string(const fstream_ptr& fPtr){
+    TRACE_SCOPE_("util::as_string");
+    FAULT_(as_string, "Failed to read entire file.", EIO);
     //TODO: platform specific way
     const off_t size = Try_(file_size(fPtr).context("Failed to get the size of the file."));
     
-    std::string buf;
-    buf.resize(size);
+    std::string buf = Try_(try_make_string(size));
     const off_t ret = std::fread(&buf[0], 1, size, fPtr.get());
     if(ret != size){
-      return io_error{"Failed to read entire file."};
+      return io_error::from_errno("Failed to read entire file.", std::ferror(fPtr.get()) ? errno : 0);
+    }
+    return buf;
+  }
+
+  IOError<buffer> as_buffer(const fstream_ptr& fPtr){
+    TRACE_SCOPE_("util::as_buffer");
+    FAULT_(as_string, "Failed to read entire file.", EIO);
+    const off_t size = Try_(file_size(fPtr).context("Failed to get the size of the file."));
+
+    buffer buf = Try_(try_make_buffer(size));
+    const off_t ret = std::fread(buf.data(), 1, size, fPtr.get());
+    if(ret != size){
+      return io_error::from_errno("Failed to read entire file.", std::ferror(fPtr.get()) ? errno : 0);
     }
-    return std::move(buf);
+    return buf;
+  }
+
+  mapped_view& mapped_view::operator=(mapped_view&& other) noexcept {
+    if(this != &other){
+      if(data_ != nullptr){
+        ::munmap(const_cast<char*>(data_), size_);
+      }
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  mapped_view::~mapped_view() {
+    if(data_ != nullptr){
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  IOError<mapped_view> map_file(const char* path, map_options options){
+    TRACE_SCOPE_("util::map_file");
+    FAULT_(map_file, "Failed to map file.", EIO, path);
+    // O_NONBLOCK: opening a FIFO without a writer would wait for one.
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if(fd == -1){
+      return io_error::from_errno("Failed to open file.", errno, path);
+    }
+    struct stat stbuf;
+    if(fstat(fd, &stbuf) != 0){
+      const int err = errno;
+      ::close(fd);
+      return io_error::from_errno("Unable to fstat fd.", err, path);
+    }
+    // Pipes, devices and directories have no size to map.
+    if(!S_ISREG(stbuf.st_mode)){
+      ::close(fd);
+      return io_error::from_errno("Not a regular file.", EINVAL, path);
+    }
+    const std::size_t size = static_cast<std::size_t>(stbuf.st_size);
+    if(size == 0){
+      // mmap() refuses a zero length.
+      ::close(fd);
+      return mapped_view();
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if(options.populate){
+      flags |= MAP_POPULATE;
+    }
+#endif
+    void* addr = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    const int err = errno;
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if(addr == MAP_FAILED){
+      return io_error::from_errno("Failed to map file.", err, path);
+    }
+
+    // Hints: the mapping works the same if the kernel ignores them.
+    static const int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED};
+    if(options.access != map_options::advice::normal){
+      ::madvise(addr, size, advice[static_cast<int>(options.access)]);
+    }
+#ifdef MADV_HUGEPAGE
+    if(options.huge_pages){
+      ::madvise(addr, size, MADV_HUGEPAGE);
+    }
+#endif
+    return mapped_view(static_cast<const char*>(addr), size);
+  }
+
+  IOError<mapped_view> map_file(const std::string& path, map_options options){
+    return map_file(path.c_str(), options);
   }
 }
@@ -7,30 +7,91 @@
 #ifndef UTILS_HPP58921
 #define UTILS_HPP58921
 
+#include <cerrno>
 #include <cstdint>
 #include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
 #include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <cstddef>
+#include <span>
+#endif
 
 #include "result.hpp"
+#include "result_fwd.hpp"
 
-namespace util {
+RESULT_EXPORT namespace util {
   using fstream_ptr = std::unique_ptr<std::FILE, void(*)(std::FILE*)>;
 
+  /**
+   *  Error type of the io helpers.
+   *
+   *  A 16 byte trivially copyable value: the errno, a description of the
+   *  failed operation, and ids for the path and the context chain. The
+   *  description is kept by address and must be a string literal; paths and
+   *  context messages are interned, copied once into fixed global pools (one
+   *  each), so they only need to live through the call. Nothing is formatted
+   *  until get_context() is called, so creating, copying or adding context
+   *  to an io_error never allocates. Once a pool is full, new strings are
+   *  left out.
+   */
   struct io_error {
-    static io_error from_context(const char*);
+    io_error() = default;
+
+    // Taking @p op as an array keeps runtime strings out: anything built on
+    // the fly goes through context().
+    template<std::size_t N>
+    static io_error from_context(const char (&op)[N]) noexcept {
+      return {op, 0, 0};
+    }
+
+    template<std::size_t N>
+    static io_error from_errno(const char (&op)[N], int errnum) noexcept {
+      return {op, errnum, 0};
+    }
+
+    template<std::size_t N>
+    static io_error from_errno(const char (&op)[N], int errnum, const char* path) {
+      return {op, errnum, intern_path(path)};
+    }
 
     void context(const char*);
 
-    friend const char* get_context(const io_error& ioe){
-      return ioe.buf.c_str();
+    int errnum() const noexcept {
+      return errnum_;
+    }
+
+    const char* what() const noexcept {
+      return op_ ? op_ : "Unknown io error.";
+    }
+
+    // nullptr if no path was recorded (or the pool was full).
+    const char* path() const noexcept;
+
+    // Renders into a thread local buffer, valid until the next call on the
+    // same thread.
+    friend const char* get_context(const io_error& ioe);
+
+  private:
+    static uint16_t intern_path(const char* path);
+
+    io_error(const char* op, int errnum, uint16_t path_id) noexcept
+      : op_(op), errnum_(errnum), path_id_(path_id) {
     }
 
-    std::string buf;
+    const char* op_   = nullptr;
+    int32_t errnum_   = 0;
+    uint16_t path_id_ = 0;
+    uint16_t ctx_id_  = 0;
   };
 
-  template<typename T>
-  using IOError = util::Result<T, io_error>;
+  static_assert(sizeof(io_error) == 16, "io_error should stay two words.");
+  static_assert(std::is_trivially_copyable<io_error>::value, "");
 
   struct openmode {
     enum : uint32_t {
@@ -48,11 +109,197 @@ namespace util {
     const char* to_modestring() const;
   };
 
+  namespace details {
+    template<typename C>
+    io_error alloc_error(const C& c, std::size_t n) {
+      if (n > c.max_size()) {
+        return io_error::from_errno("Allocation too large.", EOVERFLOW);
+      }
+      return io_error::from_errno("Out of memory.", ENOMEM);
+    }
+  } // namespace details
+
+  // Fallible allocation helpers for the standard containers. Sizes past
+  // max_size() are reported as an io_error (EOVERFLOW), and with exceptions
+  // so is std::bad_alloc (ENOMEM). Without exceptions a container that runs
+  // out of memory aborts; try_make_buffer() and as_buffer() below report it
+  // in every mode.
+
+  template<typename C>
+  IOError<C&> try_reserve(C& c, std::size_t n) {
+    if (n > c.max_size()) {
+      return details::alloc_error(c, n);
+    }
+#if RESULT_EXCEPTIONS
+    try {
+      c.reserve(n);
+    } catch (const std::bad_alloc&) {
+      return details::alloc_error(c, n);
+    }
+#else
+    c.reserve(n);
+#endif
+    return Ok(c);
+  }
+
+  template<typename C>
+  IOError<C&> try_resize(C& c, std::size_t n) {
+    if (n > c.max_size()) {
+      return details::alloc_error(c, n);
+    }
+#if RESULT_EXCEPTIONS
+    try {
+      c.resize(n);
+    } catch (const std::bad_alloc&) {
+      return details::alloc_error(c, n);
+    }
+#else
+    c.resize(n);
+#endif
+    return Ok(c);
+  }
+
+  // A string of @p size zeroed chars.
+  IOError<std::string> try_make_string(std::size_t size);
+
+  /**
+   *  Chars on the heap from a nothrow new. Unlike a std::string, getting
+   *  one can fail with an io_error (ENOMEM) when built without exceptions.
+   */
+  class buffer {
+  public:
+    buffer() = default;
+
+    char* data() noexcept {
+      return data_.get();
+    }
+
+    const char* data() const noexcept {
+      return data_.get();
+    }
+
+    std::size_t size() const noexcept {
+      return size_;
+    }
+
+    bool empty() const noexcept {
+      return size_ == 0;
+    }
+
+    const char* begin() const noexcept {
+      return data_.get();
+    }
+
+    const char* end() const noexcept {
+      return data_.get() + size_;
+    }
+
+#if __cplusplus >= 201703L
+    std::string_view as_string_view() const noexcept {
+      return {data_.get(), size_};
+    }
+#endif
+
+  private:
+    friend IOError<buffer> try_make_buffer(std::size_t);
+
+    buffer(std::unique_ptr<char[]> data, std::size_t size) noexcept
+      : data_(std::move(data)), size_(size) {
+    }
+
+    std::unique_ptr<char[]> data_;
+    std::size_t size_ = 0;
+  };
+
+  // A buffer of @p size uninitialized chars.
+  IOError<buffer> try_make_buffer(std::size_t size);
+
   IOError<fstream_ptr> open(const std::string& path, openmode);
   IOError<fstream_ptr> open(const char* path, openmode);
 
   IOError<std::string> as_string(const fstream_ptr&);
+  // as_string() into a buffer: running out of memory is an error in every
+  // mode.
+  IOError<buffer> as_buffer(const fstream_ptr&);
   IOError<std::vector<unsigned char>> as_bytes(const fstream_ptr&);
+
+  struct map_options {
+    enum class advice { normal, sequential, random, willneed };
+
+    // Fault every page in up front (MAP_POPULATE) rather than on first use.
+    bool populate = false;
+    // madvise() hint for the whole mapping.
+    advice access = advice::normal;
+    // Transparent huge pages (MADV_HUGEPAGE), where the kernel does them for
+    // file mappings. Like the advice, a hint: never an error.
+    bool huge_pages = false;
+  };
+
+  /**
+   *  A read-only mapping of a whole file, unmapped when destroyed. Nothing
+   *  is copied: pages are read in as they're touched, straight from the
+   *  page cache. An empty file is an empty view.
+   */
+  class mapped_view {
+  public:
+    mapped_view() = default;
+
+    mapped_view(mapped_view&& other) noexcept
+      : data_(other.data_), size_(other.size_) {
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+
+    mapped_view& operator=(mapped_view&& other) noexcept;
+
+    ~mapped_view();
+
+    const char* data() const noexcept {
+      return data_;
+    }
+
+    std::size_t size() const noexcept {
+      return size_;
+    }
+
+    bool empty() const noexcept {
+      return size_ == 0;
+    }
+
+    const char* begin() const noexcept {
+      return data_;
+    }
+
+    const char* end() const noexcept {
+      return data_ + size_;
+    }
+
+#if __cplusplus >= 201703L
+    std::string_view as_string_view() const noexcept {
+      return {data_, size_};
+    }
+#endif
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    std::span<const std::byte> as_bytes() const noexcept {
+      return {reinterpret_cast<const std::byte*>(data_), size_};
+    }
+#endif
+
+  private:
+    friend IOError<mapped_view> map_file(const char*, map_options);
+
+    mapped_view(const char* data, std::size_t size) noexcept
+      : data_(data), size_(size) {
+    }
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  // Maps the regular file at @p path read-only.
+  IOError<mapped_view> map_file(const char* path, map_options = {});
+  IOError<mapped_view> map_file(const std::string& path, map_options = {});
 }
 
 #endif /* !UTILS_HPP58921 */
@@ -0,0 +1,395 @@
+/*
+ * validated.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MPLv2 license.
+ */
+
+#ifndef VALIDATED_HPP_3HW0MZPE
+#define VALIDATED_HPP_3HW0MZPE
+
+#include "result.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+  namespace details {
+
+    /**
+     *  Vector keeping the first @p N elements inline, only going to the heap
+     *  once it grows past N.
+     */
+    template<typename T, std::size_t N>
+    class inline_vector {
+      static_assert(N > 0, "inline_vector needs some inline capacity.");
+
+    public:
+      inline_vector() noexcept = default;
+
+      inline_vector(std::initializer_list<T> init) {
+        for (const T& v : init) {
+          push_back(v);
+        }
+      }
+
+      inline_vector(const inline_vector& other) {
+        append(other);
+      }
+
+      inline_vector(inline_vector&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value) {
+        steal(std::move(other));
+      }
+
+      inline_vector& operator=(const inline_vector& other) {
+        if (this != &other) {
+          clear();
+          append(other);
+        }
+        return *this;
+      }
+
+      inline_vector& operator=(inline_vector&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value) {
+        if (this != &other) {
+          release();
+          steal(std::move(other));
+        }
+        return *this;
+      }
+
+      ~inline_vector() {
+        release();
+      }
+
+      // @p args may refer to an element of this vector: when it has to grow,
+      // the new element is built before the old ones move out.
+      template<typename... Args>
+      T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+          return grow_emplace(capacity_ * 2, std::forward<Args>(args)...);
+        }
+        T* slot = ::new (data_ + size_) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+      }
+
+      void push_back(const T& v) {
+        emplace_back(v);
+      }
+
+      void push_back(T&& v) {
+        emplace_back(std::move(v));
+      }
+
+      // By index: @p other may be *this, whose storage moves as it grows.
+      template<std::size_t M>
+      void append(const inline_vector<T, M>& other) {
+        const std::size_t count = other.size();
+        for (std::size_t i = 0; i < count; ++i) {
+          push_back(other[i]);
+        }
+      }
+
+      template<std::size_t M>
+      void append(inline_vector<T, M>&& other) {
+        for (T& v : other) {
+          push_back(std::move(v));
+        }
+        other.clear();
+      }
+
+      void clear() noexcept {
+        for (std::size_t i = 0; i < size_; ++i) {
+          data_[i].~T();
+        }
+        size_ = 0;
+      }
+
+      std::size_t size() const noexcept {
+        return size_;
+      }
+
+      bool empty() const noexcept {
+        return size_ == 0;
+      }
+
+      // True once the elements no longer fit in the inline storage.
+      bool spilled() const noexcept {
+        return data_ != inline_data();
+      }
+
+      T& operator[](std::size_t i) noexcept {
+        return data_[i];
+      }
+
+      const T& operator[](std::size_t i) const noexcept {
+        return data_[i];
+      }
+
+      T* begin() noexcept {
+        return data_;
+      }
+
+      T* end() noexcept {
+        return data_ + size_;
+      }
+
+      const T* begin() const noexcept {
+        return data_;
+      }
+
+      const T* end() const noexcept {
+        return data_ + size_;
+      }
+
+    private:
+      T* inline_data() noexcept {
+        return reinterpret_cast<T*>(storage_);
+      }
+
+      const T* inline_data() const noexcept {
+        return reinterpret_cast<const T*>(storage_);
+      }
+
+      template<typename... Args>
+      T& grow_emplace(std::size_t capacity, Args&&... args) {
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+#if RESULT_EXCEPTIONS
+        try {
+          ::new (data + size_) T(std::forward<Args>(args)...);
+        } catch (...) {
+          ::operator delete(data);
+          throw;
+        }
+#else
+        ::new (data + size_) T(std::forward<Args>(args)...);
+#endif
+        for (std::size_t i = 0; i < size_; ++i) {
+          ::new (data + i) T(std::move(data_[i]));
+          data_[i].~T();
+        }
+        if (spilled()) {
+          ::operator delete(data_);
+        }
+        data_     = data;
+        capacity_ = capacity;
+        return data_[size_++];
+      }
+
+      void release() noexcept {
+        clear();
+        if (spilled()) {
+          ::operator delete(data_);
+        }
+        data_     = inline_data();
+        capacity_ = N;
+      }
+
+      // Expects *this to be empty and inline.
+      void steal(inline_vector&& other) {
+        if (other.spilled()) {
+          data_           = other.data_;
+          size_           = other.size_;
+          capacity_       = other.capacity_;
+          other.data_     = other.inline_data();
+          other.size_     = 0;
+          other.capacity_ = N;
+        } else {
+          append(std::move(other));
+        }
+      }
+
+      alignas(T) unsigned char storage_[sizeof(T) * N];
+      T* data_              = inline_data();
+      std::size_t size_     = 0;
+      std::size_t capacity_ = N;
+    };
+  } // namespace details
+
+  template<typename E, std::size_t N = 4>
+  using error_list = details::inline_vector<E, N>;
+
+  /**
+   *  Like Result<T, E>, but an invalid Validated carries every error found
+   *  instead of only the first one. Up to @p N errors are stored inline.
+   *
+   *  Combine several with validate(), which reports the errors of all its
+   *  arguments in one go:
+   *
+   *  auto cfg = util::validate(make_config,
+   *                            check_port(ini), check_host(ini), check_user(ini));
+   */
+  template<typename T, typename E, std::size_t N = 4>
+  class Validated {
+  public:
+    using value_type  = T;
+    using error_type  = E;
+    using errors_type = error_list<E, N>;
+
+    template<typename U>
+    Validated(details::OkWrapper<U>&& val)
+      : res_(std::move(val)) {
+    }
+
+    template<typename U>
+    Validated(details::ErrWrapper<U>&& e)
+      : res_(Err(errors_type{})) {
+      res_.err().push_back(std::forward<U>(e.contents));
+    }
+
+    // @p errors mustn't be empty, to_first_error() aborts if it is.
+    explicit Validated(errors_type&& errors)
+      : res_(Err(std::move(errors))) {
+    }
+
+    // A Result's error becomes the only error.
+    Validated(Result<T, E>&& r)
+      : res_(Err(errors_type{})) {
+      if (r.is_ok()) {
+        res_ = Ok(std::move(r).ok());
+      } else {
+        res_.err().push_back(std::move(r).err());
+      }
+    }
+
+    bool is_valid() const noexcept {
+      return res_.is_ok();
+    }
+
+    explicit operator bool() const noexcept {
+      return is_valid();
+    }
+
+    T& value(const char* msg = nullptr) & {
+      return res_.ok(msg);
+    }
+
+    const T& value(const char* msg = nullptr) const & {
+      return res_.ok(msg);
+    }
+
+    T&& value(const char* msg = nullptr) && {
+      return std::move(res_).ok(msg);
+    }
+
+    const errors_type& errors(const char* msg = nullptr) const & {
+      return res_.err(msg);
+    }
+
+    errors_type&& errors(const char* msg = nullptr) && {
+      return std::move(res_).err(msg);
+    }
+
+    // Every error, or the value.
+    Result<T, errors_type> to_result() && {
+      return std::move(res_);
+    }
+
+    // Only the first error, or the value.
+    Result<T, E> to_first_error() && {
+      if (is_valid()) {
+        return Ok(std::move(res_).ok());
+      }
+      if (res_.err().empty()) {
+        std::fprintf(stderr, "to_first_error() on a Validated without errors.\n");
+        std::abort();
+      }
+      return Err(std::move(res_.err()[0]));
+    }
+
+  private:
+    Result<T, errors_type> res_;
+  };
+
+  namespace details {
+    // Result<T, E> arguments are treated as Validated<T, E, N>.
+    template<typename V, typename E, std::size_t N>
+    struct as_validated {
+      using type = std::decay_t<V>;
+    };
+
+    template<typename T, typename E, std::size_t N>
+    struct as_validated<Result<T, E>, E, N> {
+      using type = Validated<T, E, N>;
+    };
+
+    template<typename V, typename E, std::size_t N>
+    using as_validated_t =
+      typename as_validated<std::decay_t<V>, E, N>::type;
+
+    template<typename V>
+    struct validated_params;
+
+    template<typename T, typename E, std::size_t N>
+    struct validated_params<Validated<T, E, N>> {
+      using error_type                 = E;
+      static constexpr std::size_t cap = N;
+    };
+
+    template<typename T, typename E>
+    struct validated_params<Result<T, E>> {
+      using error_type                 = E;
+      static constexpr std::size_t cap = 4;
+    };
+
+    inline bool all_valid() {
+      return true;
+    }
+
+    template<typename V, typename... Vs>
+    bool all_valid(const V& v, const Vs&... vs) {
+      return v.is_valid() && all_valid(vs...);
+    }
+
+    template<typename Errors>
+    void collect_errors(Errors&) {
+    }
+
+    template<typename Errors, typename V, typename... Vs>
+    void collect_errors(Errors& errors, V& v, Vs&... vs) {
+      if (!v.is_valid()) {
+        errors.append(std::move(v).errors());
+      }
+      collect_errors(errors, vs...);
+    }
+
+    template<typename E, std::size_t N, typename F, typename... Vs>
+    auto validate_impl(F&& fn, Vs... vs)
+      -> Validated<std::decay_t<decltype(fn(std::move(vs).value()...))>, E, N> {
+      if (all_valid(vs...)) {
+        return Ok(fn(std::move(vs).value()...));
+      }
+      error_list<E, N> errors;
+      collect_errors(errors, vs...);
+      return Validated<std::decay_t<decltype(fn(std::move(vs).value()...))>,
+                       E,
+                       N>{std::move(errors)};
+    }
+  } // namespace details
+
+  /**
+   *  Applicative combination: if every argument is valid, returns
+   *  @p fn(values...), otherwise the errors of all invalid arguments in
+   *  order. Arguments can be Validated or Result with the same error type
+   *  and any inline capacity; the result's is taken from the first argument.
+   */
+  template<typename F, typename V, typename... Vs>
+  auto validate(F&& fn, V&& v, Vs&&... vs) {
+    using params = details::validated_params<std::decay_t<V>>;
+    using E      = typename params::error_type;
+    constexpr std::size_t N = params::cap;
+    return details::validate_impl<E, N>(
+      std::forward<F>(fn),
+      details::as_validated_t<V, E, N>(std::forward<V>(v)),
+      details::as_validated_t<Vs, E, N>(std::forward<Vs>(vs))...);
+  }
+} // namespace util
+
+#endif /* end of include guard: VALIDATED_HPP_3HW0MZPE */